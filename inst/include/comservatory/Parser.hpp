@@ -131,7 +131,7 @@ private:
     template<class Input>
     void store_nan(Input& input, Contents& info, size_t column, size_t line) const {
         input.advance();
-        expect_fixed(input, "an", "AN", column, line); // i.e., NaN or any of its capitalizations.
+        expect_keyword(input, "an", column, line); // i.e., NaN or any of its capitalizations.
         auto* current = check_column_type(info, NUMBER, column, line);
         static_cast<NumberField*>(current)->push_back(std::numeric_limits<double>::quiet_NaN());
     }
@@ -139,7 +139,7 @@ private:
     template<class Input>
     void store_inf(Input& input, Contents& info, size_t column, size_t line, bool negative) const {
         input.advance();
-        expect_fixed(input, "nf", "NF", column, line); // i.e., Inf or any of its capitalizations.
+        expect_keyword(input, "nf", column, line); // i.e., Inf or any of its capitalizations.
         auto* current = check_column_type(info, NUMBER, column, line);
 
         double val = std::numeric_limits<double>::infinity();
@@ -212,7 +212,7 @@ private:
         input.advance();
         if (!input.valid()) {
             throw std::runtime_error("truncated complex number in " + get_location(column, line));
-        } else if (!std::isdigit(input.get())) {
+        } else if (!is_digit(input.get())) {
             throw std::runtime_error("incorrectly formatted complex number in " + get_location(column, line));
         }
 
@@ -314,71 +314,71 @@ private:
         size_t column = 0;
         size_t line = 1;
         while (1) {
-            switch (input.get()) {
-                case '"':
+            switch (classify_leading(input.get())) {
+                case LEAD_QUOTE:
                     {
                         auto* current = check_column_type(info, STRING, column, line);
                         static_cast<StringField*>(current)->push_back(to_string(input, column, line));
                     }
                     break;
 
-                case 't': case 'T':
+                case LEAD_TRUE:
                     {
                         input.advance();
-                        expect_fixed(input, "rue", "RUE", column, line);
+                        expect_keyword(input, "rue", column, line);
                         auto* current = check_column_type(info, BOOLEAN, column, line);
                         static_cast<BooleanField*>(current)->push_back(true);
                     }
                     break;
 
-                case 'f': case 'F':
+                case LEAD_FALSE:
                     {
                         input.advance();
-                        expect_fixed(input, "alse", "ALSE", column, line);
+                        expect_keyword(input, "alse", column, line);
                         auto* current = check_column_type(info, BOOLEAN, column, line);
                         static_cast<BooleanField*>(current)->push_back(false);
                     }
                     break;
 
-                case 'N':
+                case LEAD_UPPER_N:
                     store_na_or_nan(input, info, column, line);
                     break;
 
-                case 'n': 
+                case LEAD_LOWER_N:
                     store_nan(input, info, column, line);
                     break;
                 
-                case 'i': case 'I':
+                case LEAD_INF:
                     store_inf(input, info, column, line, false);
                     break;
 
-                case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
+                case LEAD_DIGIT:
                     store_number_or_complex(input, info, column, line, false);
                     break;
 
-                case '+':
+                case LEAD_PLUS:
                     input.advance();
                     if (!input.valid()) {
                         throw std::runtime_error("truncated field in " + get_location(column, line)); 
-                    } else if (!std::isdigit(input.get())) {
+                    } else if (!is_digit(input.get())) {
                         throw std::runtime_error("invalid number in " + get_location(column, line)); 
                     }
                     store_number_or_complex(input, info, column, line, false);
                     break;
 
-                case '-':
+                case LEAD_MINUS:
                     {
                         input.advance();
                         if (!input.valid()) {
                             throw std::runtime_error("truncated field in " + get_location(column, line));
                         }
 
-                        char next = input.get();
-                        if (next == 'i' || next == 'I') {
+                        auto next = classify_leading(input.get());
+                        if (next == LEAD_INF) {
                             store_inf(input, info, column, line, true);
-                        } else if (next == 'n' || next == 'N') {
+                        } else if (next == LEAD_UPPER_N || next == LEAD_LOWER_N) {
                             store_nan(input, info, column, line);
-                        } else if (std::isdigit(next)) {
+                        } else if (next == LEAD_DIGIT) {
                             store_number_or_complex(input, info, column, line, true);
                         } else {
                             throw std::runtime_error("incorrectly formatted number in " + get_location(column, line));
@@ -386,7 +386,7 @@ private:
                     }
                     break;
 
-                case '\n':
+                case LEAD_NEWLINE:
                     throw std::runtime_error(get_location(column, line) + " is empty");
 
                 default:
@@ -6,6 +6,7 @@
 #include <complex>
 #include <cmath>
 #include <array>
+#include <cstdint>
 
 namespace comservatory {
 
@@ -45,6 +46,52 @@ std::string to_string(Input& input, size_t column, size_t line) {
     return output;
 }
 
+// Classes for the leading byte of each field, so that the parser can dispatch
+// on a single lookup into a 256-entry table rather than a chain of comparisons.
+enum LeadingClass : unsigned char {
+    LEAD_INVALID,
+    LEAD_QUOTE,
+    LEAD_TRUE,
+    LEAD_FALSE,
+    LEAD_UPPER_N,
+    LEAD_LOWER_N,
+    LEAD_INF,
+    LEAD_DIGIT,
+    LEAD_PLUS,
+    LEAD_MINUS,
+    LEAD_NEWLINE
+};
+
+inline constexpr std::array<unsigned char, 256> build_leading_table() {
+    std::array<unsigned char, 256> output{};
+    output['"'] = LEAD_QUOTE;
+    output['t'] = LEAD_TRUE;
+    output['T'] = LEAD_TRUE;
+    output['f'] = LEAD_FALSE;
+    output['F'] = LEAD_FALSE;
+    output['N'] = LEAD_UPPER_N;
+    output['n'] = LEAD_LOWER_N;
+    output['i'] = LEAD_INF;
+    output['I'] = LEAD_INF;
+    for (char d = '0'; d <= '9'; ++d) {
+        output[static_cast<unsigned char>(d)] = LEAD_DIGIT;
+    }
+    output['+'] = LEAD_PLUS;
+    output['-'] = LEAD_MINUS;
+    output['\n'] = LEAD_NEWLINE;
+    return output;
+}
+
+inline constexpr std::array<unsigned char, 256> leading_table = build_leading_table();
+
+inline LeadingClass classify_leading(char c) {
+    return static_cast<LeadingClass>(leading_table[static_cast<unsigned char>(c)]);
+}
+
+inline bool is_digit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
 // Assumes that 'input' is located on the first letter of the keyword (i.e.,
 // before the first letter of 'lower'). On return, 'input' is left on the
 // first character _after_ the end of the keyword.
@@ -62,6 +109,44 @@ void expect_fixed(Input& input, const std::string& lower, const std::string& upp
     }
 }
 
+// Assumes that 'input' is located on the first letter of the keyword (i.e.,
+// before the first letter of 'lower'). On return, 'input' is left on the
+// first character _after_ the end of the keyword. As all keywords are
+// alphabetic, setting the 0x20 bit of each byte folds upper-case letters onto
+// their lower-case counterparts without affecting any other matches; the
+// bytes are packed into a single word so that the case-folded comparison is
+// performed once for the entire keyword.
+template<size_t N, class Input>
+void expect_keyword(Input& input, const char (&lower)[N], size_t column, size_t line) {
+    constexpr size_t len = N - 1;
+    static_assert(len > 0 && len < 8, "keyword should fit inside a 64-bit word");
+
+    uint64_t expected = 0, fold = 0;
+    for (size_t i = 0; i < len; ++i) {
+        expected |= static_cast<uint64_t>(static_cast<unsigned char>(lower[i])) << (8 * i);
+        fold |= static_cast<uint64_t>(0x20) << (8 * i);
+    }
+
+    uint64_t observed = 0;
+    for (size_t i = 0; i < len; ++i) {
+        if (!input.valid()) {
+            // Any mismatch in the preceding characters takes precedence, for
+            // consistency with a character-by-character comparison.
+            uint64_t mask = (static_cast<uint64_t>(1) << (8 * i)) - 1;
+            if (((observed | fold) & mask) != (expected & mask)) {
+                throw std::runtime_error("unknown keyword in " + get_location(column, line));
+            }
+            throw std::runtime_error("truncated keyword in " + get_location(column, line));
+        }
+        observed |= static_cast<uint64_t>(static_cast<unsigned char>(input.get())) << (8 * i);
+        input.advance();
+    }
+
+    if ((observed | fold) != expected) {
+        throw std::runtime_error("unknown keyword in " + get_location(column, line));
+    }
+}
+
 // Assumes that 'input' is located on the first digit. On return, 'input' is
 // left on the first character _after_ the end of the number.
 template<class Input>
@@ -96,7 +181,7 @@ double to_number(Input& input, size_t column, size_t line) {
             break;
         } else if (is_terminator(val)) {
             return value;
-        } else if (!std::isdigit(val)) {
+        } else if (!is_digit(val)) {
             throw std::runtime_error("invalid number containing '" + std::string(1, val) + "' at " + get_location(column, line));
         }
         value *= 10;
@@ -111,7 +196,7 @@ double to_number(Input& input, size_t column, size_t line) {
         }
 
         char val = input.get();
-        if (!std::isdigit(val)) {
+        if (!is_digit(val)) {
             throw std::runtime_error("'.' must be followed by at least one digit at " + get_location(column, line));
         }
         value += (val - '0') / fractional;
@@ -127,7 +212,7 @@ double to_number(Input& input, size_t column, size_t line) {
                 break;
             } else if (is_terminator(val)) {
                 return value;
-            } else if (!std::isdigit(val)) {
+            } else if (!is_digit(val)) {
                 throw std::runtime_error("invalid fraction containing '" + std::string(1, val) + "' at " + get_location(column, line));
             }
             fractional *= 10;
@@ -147,7 +232,7 @@ double to_number(Input& input, size_t column, size_t line) {
         }
 
         char val = input.get();
-        if (!std::isdigit(val)) {
+        if (!is_digit(val)) {
             if (val == '-') {
                 negative_exponent = true;
             } else if (val != '+') {
@@ -159,7 +244,7 @@ double to_number(Input& input, size_t column, size_t line) {
                 throw std::runtime_error("line " + std::to_string(line + 1) + " should be terminated with a newline");
             }
             val = input.get();
-            if (!std::isdigit(val)) {
+            if (!is_digit(val)) {
                 throw std::runtime_error("exponent sign must be followed by at least one digit in number at " + get_location(column, line));
             }
         }
@@ -173,7 +258,7 @@ double to_number(Input& input, size_t column, size_t line) {
             char val = input.get();
             if (is_terminator(val)) {
                 break;
-            } else if (!std::isdigit(val)) {
+            } else if (!is_digit(val)) {
                 throw std::runtime_error("invalid exponent containing '" + std::string(1, val) + "' at " + get_location(column, line));
             }
             exponent *= 10;
@@ -30,3 +30,7 @@ harvester() {
 }
 
 harvester comservatory https://github.com/ArtifactDB/comservatory v2.0.1
+
+# Local modifications that have not yet been merged upstream; these should be
+# removed once a comservatory release containing them is pinned above.
+patch -p1 < patches/comservatory.patch
@@ -0,0 +1,116 @@
+#ifndef CSV_COLUMN_STATS_H
+#define CSV_COLUMN_STATS_H
+
+#include "Rcpp.h"
+#include "comservatory/comservatory.hpp"
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <complex>
+#include <algorithm>
+
+/** Defining the per-column statistics. **/
+
+// These are accumulated as each value is pushed, so that downstream code
+// doesn't need to make another pass over each column for the same information.
+struct ColumnStats {
+    size_t num_missing = 0;
+    size_t num_nan = 0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    bool integral = true;
+    size_t max_bytes = 0;
+
+    void add(double x) {
+        if (std::isnan(x)) {
+            ++num_nan;
+            integral = false;
+            return;
+        }
+        if (x < min) {
+            min = x;
+        }
+        if (x > max) {
+            max = x;
+        }
+        if (integral && (!std::isfinite(x) || x != std::trunc(x))) {
+            integral = false;
+        }
+    }
+
+    void add(bool x) {
+        double val = x;
+        if (val < min) {
+            min = val;
+        }
+        if (val > max) {
+            max = val;
+        }
+    }
+
+    void add(const std::string& x) {
+        if (x.size() > max_bytes) {
+            max_bytes = x.size();
+        }
+    }
+
+    void add(const std::complex<double>&) {}
+
+    // Used to combine statistics from multiple shards.
+    void merge(const ColumnStats& other) {
+        num_missing += other.num_missing;
+        num_nan += other.num_nan;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+        integral = integral && other.integral;
+        max_bytes = std::max(max_bytes, other.max_bytes);
+    }
+};
+
+/** Assembling the statistics for return to R. **/
+
+struct StatsCollector {
+    StatsCollector(size_t n) : num_missing(n), num_nan(n), min(n), max(n), integral(n), max_bytes(n) {}
+
+    void set(size_t i, const ColumnStats& stats, comservatory::Type type) {
+        num_missing[i] = stats.num_missing;
+        num_nan[i] = stats.num_nan;
+
+        bool observed = (stats.min <= stats.max);
+        bool is_numeric = (type == comservatory::NUMBER || type == comservatory::BOOLEAN);
+        min[i] = (is_numeric && observed ? stats.min : NA_REAL);
+        max[i] = (is_numeric && observed ? stats.max : NA_REAL);
+        integral[i] = (type == comservatory::NUMBER ? static_cast<int>(stats.integral) : NA_LOGICAL);
+        max_bytes[i] = (type == comservatory::STRING ? static_cast<double>(stats.max_bytes) : NA_REAL);
+    }
+
+    void set_missing(size_t i, size_t n) {
+        num_missing[i] = n;
+        num_nan[i] = 0;
+        min[i] = NA_REAL;
+        max[i] = NA_REAL;
+        integral[i] = NA_LOGICAL;
+        max_bytes[i] = NA_REAL;
+    }
+
+    Rcpp::List yield() const {
+        Rcpp::List output(6);
+        output[0] = num_missing;
+        output[1] = num_nan;
+        output[2] = min;
+        output[3] = max;
+        output[4] = integral;
+        output[5] = max_bytes;
+        output.names() = Rcpp::CharacterVector::create("missing", "nan", "min", "max", "integral", "max.bytes");
+        return output;
+    }
+
+    // Counts are stored as doubles to avoid overflow for very long files.
+    Rcpp::NumericVector num_missing, num_nan;
+    Rcpp::NumericVector min, max;
+    Rcpp::LogicalVector integral;
+    Rcpp::NumericVector max_bytes;
+};
+
+#endif
@@ -0,0 +1,714 @@
+#ifndef HDF5_LIST_PARSER_H
+#define HDF5_LIST_PARSER_H
+
+#include "uzuki2/uzuki2.hpp"
+#include "H5Cpp.h"
+#include "JsonListStreamer.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+
+/**
+ * Parser for uzuki2 lists in HDF5 that also understands the packed layout
+ * written by saveObject() with list.format="hdf5.packed". In this layout, the
+ * scalar leaves of each list are not stored as separate groups in 'data'.
+ * Instead, they are collected into columnar datasets in a 'packed' subgroup
+ * of the list's group:
+ *
+ * - 'index', an integer dataset containing the 0-based position of each
+ *   packed leaf in the list, in increasing order.
+ * - 'type', an integer dataset containing the type of each packed leaf, see
+ *   PackedLeafType below.
+ * - 'integer', 'number', 'boolean' and 'string', datasets containing the
+ *   values of all packed leaves of the corresponding type, in order of their
+ *   positions. Date and date-time leaves are stored in 'string'. Each dataset
+ *   may have a missing placeholder attribute, as for regular vectors.
+ *
+ * All other children are stored in 'data' as usual but are named after their
+ * positions in the list, so the list length is the number of children in
+ * 'data' plus the length of 'index'. Everything else follows version 1.3 of
+ * the uzuki2 specification. If packing is disabled, any 'packed' subgroup is
+ * ignored and the parser handles regular uzuki2 lists of any 1.x version.
+ *
+ * Nested lists are traversed with an explicit stack, so deeply nested lists
+ * do not overflow the call stack.
+ */
+
+enum PackedLeafType : int32_t {
+    PACKED_NOTHING = 0,
+    PACKED_INTEGER = 1,
+    PACKED_NUMBER = 2,
+    PACKED_BOOLEAN = 3,
+    PACKED_STRING = 4,
+    PACKED_DATE = 5,
+    PACKED_DATETIME = 6
+};
+
+template<class Provisioner_, class Externals_>
+class Hdf5ListParser {
+public:
+    Hdf5ListParser(Externals_ externals, bool packed = true) : 
+        externals(std::move(externals)), used_externals(this->externals.size()), allow_packed(packed) {}
+
+    typedef std::shared_ptr<uzuki2::Base> Pointer;
+
+private:
+    Externals_ externals;
+    std::vector<unsigned char> used_externals;
+    size_t num_used_externals = 0;
+    bool allow_packed;
+
+    struct Frame {
+        Frame(H5::Group data) : data(std::move(data)) {}
+        H5::Group data;
+        std::shared_ptr<uzuki2::List> list;
+        std::vector<size_t> children; // positions of the children in 'data'.
+        size_t next = 0;
+        size_t position = 0; // position of this list in its parent.
+        std::string path;
+    };
+
+    std::vector<Frame> stack;
+    std::string location;
+
+    // Version 1.0 of the specification does not use placeholder attributes;
+    // instead, -2^31 and R's NA are always treated as missing. It also uses
+    // separate types for dates, date-times and ordered factors.
+    bool legacy_version = false;
+
+    /** Reading utilities. **/
+
+    static std::string read_string_attribute(const H5::H5Object& handle, const char* name) {
+        if (!handle.attrExists(name)) {
+            throw std::runtime_error("expected a '" + std::string(name) + "' attribute");
+        }
+        auto ahandle = handle.openAttribute(name);
+        if (ahandle.getTypeClass() != H5T_STRING || ahandle.getSpace().getSimpleExtentNdims() != 0) {
+            throw std::runtime_error("expected the '" + std::string(name) + "' attribute to be a scalar string");
+        }
+        std::string output;
+        ahandle.read(ahandle.getStrType(), output);
+        return output;
+    }
+
+    template<class Reader_>
+    static std::vector<std::string> read_strings(const H5::StrType& stype, hsize_t len, Reader_ reader) {
+        std::vector<std::string> output;
+        output.reserve(len);
+        if (len == 0) {
+            return output;
+        }
+
+        if (stype.isVariableStr()) {
+            std::vector<char*> buffer(len);
+            reader(stype, buffer.data());
+            for (hsize_t i = 0; i < len; ++i) {
+                output.emplace_back(buffer[i] == NULL ? "" : buffer[i]);
+            }
+            H5::DataSpace mspace(1, &len);
+            H5Dvlen_reclaim(stype.getId(), mspace.getId(), H5P_DEFAULT, buffer.data());
+        } else {
+            size_t size = stype.getSize();
+            std::vector<char> buffer(size * len);
+            reader(stype, buffer.data());
+            for (hsize_t i = 0; i < len; ++i) {
+                const char* start = buffer.data() + i * size;
+                output.emplace_back(start, strnlen(start, size));
+            }
+        }
+
+        return output;
+    }
+
+    static bool fits_in_int32(const H5::DataType& dtype) {
+        if (dtype.getClass() != H5T_INTEGER) {
+            return false;
+        }
+        if (H5Tget_sign(dtype.getId()) == H5T_SGN_NONE) {
+            return dtype.getSize() < 4;
+        } else {
+            return dtype.getSize() <= 4;
+        }
+    }
+
+    static bool fits_in_double(const H5::DataType& dtype) {
+        auto cls = dtype.getClass();
+        if (cls == H5T_FLOAT) {
+            return dtype.getSize() <= 8;
+        }
+        return fits_in_int32(dtype);
+    }
+
+    static hsize_t vector_length(const H5::DataSet& dhandle) {
+        auto space = dhandle.getSpace();
+        if (space.getSimpleExtentNdims() > 1) {
+            throw std::runtime_error("expected a scalar or 1-dimensional dataset");
+        }
+        return space.getSimpleExtentNpoints();
+    }
+
+    template<typename Type_>
+    struct Column {
+        std::vector<Type_> values;
+        bool has_placeholder = false;
+        Type_ placeholder = Type_();
+    };
+
+    static const char* placeholder_name() {
+        return "missing-value-placeholder";
+    }
+
+    static Column<int32_t> read_integer_column(const H5::DataSet& dhandle) {
+        if (!fits_in_int32(dhandle.getDataType())) {
+            throw std::runtime_error("expected an integer dataset that fits into a 32-bit signed integer");
+        }
+
+        Column<int32_t> output;
+        output.values.resize(vector_length(dhandle));
+        if (!output.values.empty()) {
+            dhandle.read(output.values.data(), H5::PredType::NATIVE_INT32);
+        }
+
+        if (dhandle.attrExists(placeholder_name())) {
+            auto ahandle = dhandle.openAttribute(placeholder_name());
+            if (!fits_in_int32(ahandle.getDataType()) || ahandle.getSpace().getSimpleExtentNdims() != 0) {
+                throw std::runtime_error("expected the missing placeholder to be a scalar integer");
+            }
+            ahandle.read(H5::PredType::NATIVE_INT32, &(output.placeholder));
+            output.has_placeholder = true;
+        }
+        return output;
+    }
+
+    static Column<double> read_number_column(const H5::DataSet& dhandle) {
+        if (!fits_in_double(dhandle.getDataType())) {
+            throw std::runtime_error("expected a floating-point or integer dataset that fits into a double");
+        }
+
+        Column<double> output;
+        output.values.resize(vector_length(dhandle));
+        if (!output.values.empty()) {
+            dhandle.read(output.values.data(), H5::PredType::NATIVE_DOUBLE);
+        }
+
+        if (dhandle.attrExists(placeholder_name())) {
+            auto ahandle = dhandle.openAttribute(placeholder_name());
+            if (!fits_in_double(ahandle.getDataType()) || ahandle.getSpace().getSimpleExtentNdims() != 0) {
+                throw std::runtime_error("expected the missing placeholder to be a scalar number");
+            }
+            ahandle.read(H5::PredType::NATIVE_DOUBLE, &(output.placeholder));
+            output.has_placeholder = true;
+        }
+        return output;
+    }
+
+    static Column<std::string> read_string_column(const H5::DataSet& dhandle) {
+        if (dhandle.getTypeClass() != H5T_STRING) {
+            throw std::runtime_error("expected a string dataset");
+        }
+
+        Column<std::string> output;
+        output.values = read_strings(dhandle.getStrType(), vector_length(dhandle), [&](const H5::DataType& type, void* buffer) -> void {
+            dhandle.read(buffer, type);
+        });
+
+        if (dhandle.attrExists(placeholder_name())) {
+            auto ahandle = dhandle.openAttribute(placeholder_name());
+            if (ahandle.getTypeClass() != H5T_STRING || ahandle.getSpace().getSimpleExtentNdims() != 0) {
+                throw std::runtime_error("expected the missing placeholder to be a scalar string");
+            }
+            ahandle.read(ahandle.getStrType(), output.placeholder);
+            output.has_placeholder = true;
+        }
+        return output;
+    }
+
+    static bool is_missing(const Column<int32_t>& col, int32_t val) {
+        return col.has_placeholder && val == col.placeholder;
+    }
+
+    static bool is_missing(const Column<double>& col, double val) {
+        if (!col.has_placeholder) {
+            return false;
+        } else if (std::isnan(col.placeholder)) {
+            // Comparing the payloads so that NaN can be distinguished from R's NA.
+            return std::memcmp(&val, &(col.placeholder), sizeof(double)) == 0;
+        } else {
+            return val == col.placeholder;
+        }
+    }
+
+    void add_implicit_missing(Column<int32_t>& col) const {
+        if (legacy_version && !col.has_placeholder) {
+            col.has_placeholder = true;
+            col.placeholder = -2147483648;
+        }
+    }
+
+    void add_implicit_missing(Column<double>& col) const {
+        if (legacy_version && !col.has_placeholder) {
+            col.has_placeholder = true;
+            uint64_t r_na = 0x7FF00000000007A2;
+            std::memcpy(&(col.placeholder), &r_na, sizeof(double));
+        }
+    }
+
+    static bool is_missing(const Column<std::string>& col, const std::string& val) {
+        return col.has_placeholder && val == col.placeholder;
+    }
+
+    static int32_t read_integer_scalar(const H5::Group& handle, const char* name) {
+        auto dhandle = handle.openDataSet(name);
+        if (dhandle.getSpace().getSimpleExtentNdims() != 0 || !fits_in_int32(dhandle.getDataType())) {
+            throw std::runtime_error("expected '" + std::string(name) + "' to be a scalar integer dataset");
+        }
+        int32_t output;
+        dhandle.read(&output, H5::PredType::NATIVE_INT32);
+        return output;
+    }
+
+    static std::string read_string_scalar(const H5::Group& handle, const char* name) {
+        auto dhandle = handle.openDataSet(name);
+        if (dhandle.getSpace().getSimpleExtentNdims() != 0 || dhandle.getTypeClass() != H5T_STRING) {
+            throw std::runtime_error("expected '" + std::string(name) + "' to be a scalar string dataset");
+        }
+        return read_string_column(dhandle).values.front();
+    }
+
+    static uzuki2::StringVector::Format parse_format(const std::string& format) {
+        if (format == "date") {
+            return uzuki2::StringVector::DATE;
+        } else if (format == "date-time") {
+            return uzuki2::StringVector::DATETIME;
+        }
+        throw std::runtime_error("unsupported format '" + format + "'");
+    }
+
+    static void check_format(const std::string& x, uzuki2::StringVector::Format format) {
+        if (format == uzuki2::StringVector::DATE && !is_date(x)) {
+            throw std::runtime_error("expected dates in YYYY-MM-DD format (got '" + x + "')");
+        } else if (format == uzuki2::StringVector::DATETIME && !is_rfc3339(x)) {
+            throw std::runtime_error("expected Internet date/times (got '" + x + "')");
+        }
+    }
+
+    /** Building the leaves. **/
+
+    template<class Vector_>
+    static void fill_names(Vector_* ptr, const H5::Group& handle, size_t len) {
+        auto names = read_string_column(handle.openDataSet("names")).values;
+        if (names.size() != len) {
+            throw std::runtime_error("length of 'names' should be equal to the number of elements");
+        }
+        for (size_t i = 0; i < len; ++i) {
+            ptr->set_name(i, std::move(names[i]));
+        }
+    }
+
+    Pointer parse_vector(const H5::Group& handle) {
+        auto type = read_string_attribute(handle, "uzuki_type");
+        auto dhandle = handle.openDataSet("data");
+        bool scalar = (dhandle.getSpace().getSimpleExtentNdims() == 0);
+        size_t len = vector_length(dhandle);
+        bool named = handle.exists("names");
+
+        if (type == "integer") {
+            auto col = read_integer_column(dhandle);
+            add_implicit_missing(col);
+            std::shared_ptr<uzuki2::IntegerVector> ptr(Provisioner_::new_Integer(len, named, scalar));
+            for (size_t i = 0; i < len; ++i) {
+                auto val = col.values[i];
+                if (is_missing(col, val)) {
+                    ptr->set_missing(i);
+                } else {
+                    ptr->set(i, val);
+                }
+            }
+            if (named) {
+                fill_names(ptr.get(), handle, len);
+            }
+            return ptr;
+        }
+
+        if (type == "number") {
+            auto col = read_number_column(dhandle);
+            add_implicit_missing(col);
+            std::shared_ptr<uzuki2::NumberVector> ptr(Provisioner_::new_Number(len, named, scalar));
+            for (size_t i = 0; i < len; ++i) {
+                auto val = col.values[i];
+                if (is_missing(col, val)) {
+                    ptr->set_missing(i);
+                } else {
+                    ptr->set(i, val);
+                }
+            }
+            if (named) {
+                fill_names(ptr.get(), handle, len);
+            }
+            return ptr;
+        }
+
+        if (type == "boolean") {
+            auto col = read_integer_column(dhandle);
+            add_implicit_missing(col);
+            std::shared_ptr<uzuki2::BooleanVector> ptr(Provisioner_::new_Boolean(len, named, scalar));
+            for (size_t i = 0; i < len; ++i) {
+                auto val = col.values[i];
+                if (is_missing(col, val)) {
+                    ptr->set_missing(i);
+                } else if (val == 0 || val == 1) {
+                    ptr->set(i, val);
+                } else {
+                    throw std::runtime_error("boolean values should be 0 or 1");
+                }
+            }
+            if (named) {
+                fill_names(ptr.get(), handle, len);
+            }
+            return ptr;
+        }
+
+        if (type == "date" || type == "date-time" || type == "ordered") {
+            if (!legacy_version) {
+                throw std::runtime_error("type '" + type + "' is only supported in version 1.0");
+            }
+        }
+
+        if (type == "string" || type == "date" || type == "date-time") {
+            auto format = uzuki2::StringVector::NONE;
+            if (handle.exists("format")) {
+                if (legacy_version) {
+                    throw std::runtime_error("'format' requires version 1.1 or later");
+                }
+                format = parse_format(read_string_scalar(handle, "format"));
+            } else if (type != "string") {
+                format = parse_format(type);
+            }
+
+            auto col = read_string_column(dhandle);
+            std::shared_ptr<uzuki2::StringVector> ptr(Provisioner_::new_String(len, named, scalar, format));
+            for (size_t i = 0; i < len; ++i) {
+                auto& val = col.values[i];
+                if (is_missing(col, val)) {
+                    ptr->set_missing(i);
+                } else {
+                    check_format(val, format);
+                    ptr->set(i, std::move(val));
+                }
+            }
+            if (named) {
+                fill_names(ptr.get(), handle, len);
+            }
+            return ptr;
+        }
+
+        if (type == "factor" || type == "ordered") {
+            auto levels = read_string_column(handle.openDataSet("levels")).values;
+            std::unordered_set<std::string> unique_levels(levels.begin(), levels.end());
+            if (unique_levels.size() != levels.size()) {
+                throw std::runtime_error("'levels' should be unique");
+            }
+
+            bool ordered = (type == "ordered");
+            if (handle.exists("ordered")) {
+                if (legacy_version) {
+                    throw std::runtime_error("'ordered' requires version 1.1 or later");
+                }
+                ordered = (read_integer_scalar(handle, "ordered") != 0);
+            }
+
+            auto col = read_integer_column(dhandle);
+            add_implicit_missing(col);
+            size_t nlevels = levels.size();
+            std::shared_ptr<uzuki2::Factor> ptr(Provisioner_::new_Factor(len, named, scalar, nlevels, ordered));
+            for (size_t i = 0; i < len; ++i) {
+                auto val = col.values[i];
+                if (is_missing(col, val)) {
+                    ptr->set_missing(i);
+                } else if (val >= 0 && static_cast<size_t>(val) < nlevels) {
+                    ptr->set(i, val);
+                } else {
+                    throw std::runtime_error("factor codes should be non-negative and less than the number of levels");
+                }
+            }
+            for (size_t l = 0; l < nlevels; ++l) {
+                ptr->set_level(l, std::move(levels[l]));
+            }
+            if (named) {
+                fill_names(ptr.get(), handle, len);
+            }
+            return ptr;
+        }
+
+        throw std::runtime_error("unknown vector type '" + type + "'");
+    }
+
+    Pointer parse_external(const H5::Group& handle) {
+        auto index = read_integer_scalar(handle, "index");
+        if (index < 0 || static_cast<size_t>(index) >= externals.size()) {
+            throw std::runtime_error("external index out of range (" + std::to_string(index) + " out of " + std::to_string(externals.size()) + ")");
+        }
+        if (used_externals[index]) {
+            throw std::runtime_error("multiple instances of type \"external\" with index " + std::to_string(index));
+        }
+        used_externals[index] = true;
+        ++num_used_externals;
+        return Pointer(Provisioner_::new_External(externals.get(index)));
+    }
+
+    /** Handling the packed leaves. **/
+
+    static std::vector<int32_t> read_packed_index(const H5::Group& phandle) {
+        auto col = read_integer_column(phandle.openDataSet("index"));
+        if (col.has_placeholder) {
+            throw std::runtime_error("'packed/index' should not contain missing values");
+        }
+        for (size_t i = 0, end = col.values.size(); i < end; ++i) {
+            if (col.values[i] < 0 || (i > 0 && col.values[i] <= col.values[i - 1])) {
+                throw std::runtime_error("'packed/index' should contain non-negative values in strictly increasing order");
+            }
+        }
+        return std::move(col.values);
+    }
+
+    static Column<int32_t> read_packed_types(const H5::Group& phandle, size_t npacked) {
+        auto col = read_integer_column(phandle.openDataSet("type"));
+        if (col.has_placeholder) {
+            throw std::runtime_error("'packed/type' should not contain missing values");
+        }
+        if (col.values.size() != npacked) {
+            throw std::runtime_error("length of 'packed/type' should be equal to that of 'packed/index'");
+        }
+        return col;
+    }
+
+    template<class Function_>
+    static auto read_packed_values(const H5::Group& phandle, const char* name, size_t expected, Function_ fun) -> decltype(fun(std::declval<H5::DataSet>())) {
+        if (!phandle.exists(name)) {
+            if (expected) {
+                throw std::runtime_error("expected a 'packed/" + std::string(name) + "' dataset");
+            }
+            return decltype(fun(std::declval<H5::DataSet>()))();
+        }
+        auto dhandle = phandle.openDataSet(name);
+        if (dhandle.getSpace().getSimpleExtentNdims() != 1) {
+            throw std::runtime_error("expected 'packed/" + std::string(name) + "' to be a 1-dimensional dataset");
+        }
+        auto output = fun(dhandle);
+        if (output.values.size() != expected) {
+            throw std::runtime_error("length of 'packed/" + std::string(name) + "' should be equal to the number of packed leaves of that type");
+        }
+        return output;
+    }
+
+    static void fill_packed(const H5::Group& phandle, const std::vector<int32_t>& index, uzuki2::List* list) {
+        auto types = read_packed_types(phandle, index.size());
+
+        size_t counts[7] = { 0, 0, 0, 0, 0, 0, 0 };
+        for (auto t : types.values) {
+            if (t < PACKED_NOTHING || t > PACKED_DATETIME) {
+                throw std::runtime_error("unknown type " + std::to_string(t) + " in 'packed/type'");
+            }
+            ++counts[t];
+        }
+
+        auto integers = read_packed_values(phandle, "integer", counts[PACKED_INTEGER], read_integer_column);
+        auto numbers = read_packed_values(phandle, "number", counts[PACKED_NUMBER], read_number_column);
+        auto booleans = read_packed_values(phandle, "boolean", counts[PACKED_BOOLEAN], read_integer_column);
+        auto strings = read_packed_values(phandle, "string", counts[PACKED_STRING] + counts[PACKED_DATE] + counts[PACKED_DATETIME], read_string_column);
+
+        size_t idex = 0, ndex = 0, bdex = 0, sdex = 0;
+        for (size_t k = 0, end = index.size(); k < end; ++k) {
+            auto type = types.values[k];
+
+            if (type == PACKED_NOTHING) {
+                list->set(index[k], Pointer(Provisioner_::new_Nothing()));
+
+            } else if (type == PACKED_INTEGER) {
+                std::shared_ptr<uzuki2::IntegerVector> ptr(Provisioner_::new_Integer(1, false, true));
+                auto val = integers.values[idex++];
+                if (is_missing(integers, val)) {
+                    ptr->set_missing(0);
+                } else {
+                    ptr->set(0, val);
+                }
+                list->set(index[k], ptr);
+
+            } else if (type == PACKED_NUMBER) {
+                std::shared_ptr<uzuki2::NumberVector> ptr(Provisioner_::new_Number(1, false, true));
+                auto val = numbers.values[ndex++];
+                if (is_missing(numbers, val)) {
+                    ptr->set_missing(0);
+                } else {
+                    ptr->set(0, val);
+                }
+                list->set(index[k], ptr);
+
+            } else if (type == PACKED_BOOLEAN) {
+                std::shared_ptr<uzuki2::BooleanVector> ptr(Provisioner_::new_Boolean(1, false, true));
+                auto val = booleans.values[bdex++];
+                if (is_missing(booleans, val)) {
+                    ptr->set_missing(0);
+                } else if (val == 0 || val == 1) {
+                    ptr->set(0, val);
+                } else {
+                    throw std::runtime_error("values of 'packed/boolean' should be 0 or 1");
+                }
+                list->set(index[k], ptr);
+
+            } else {
+                auto format = uzuki2::StringVector::NONE;
+                if (type == PACKED_DATE) {
+                    format = uzuki2::StringVector::DATE;
+                } else if (type == PACKED_DATETIME) {
+                    format = uzuki2::StringVector::DATETIME;
+                }
+                std::shared_ptr<uzuki2::StringVector> ptr(Provisioner_::new_String(1, false, true, format));
+                auto& val = strings.values[sdex++];
+                if (is_missing(strings, val)) {
+                    ptr->set_missing(0);
+                } else {
+                    check_format(val, format);
+                    ptr->set(0, std::move(val));
+                }
+                list->set(index[k], ptr);
+            }
+        }
+    }
+
+    /** Handling the lists. **/
+
+    Frame open_list(const H5::Group& handle, std::string path, size_t position) {
+        // HDF5 handles are constructed directly, as their copy assignment is deprecated.
+        Frame frame(handle.openGroup("data"));
+        frame.path = std::move(path);
+        frame.position = position;
+        size_t len = frame.data.getNumObjs();
+
+        bool has_packed = allow_packed && handle.exists("packed");
+        std::vector<int32_t> index;
+        H5::Group phandle = (has_packed ? handle.openGroup("packed") : H5::Group());
+        if (has_packed) {
+            index = read_packed_index(phandle);
+            len += index.size();
+            if (!index.empty() && static_cast<size_t>(index.back()) >= len) {
+                throw std::runtime_error("'packed/index' should be less than the length of the list");
+            }
+        }
+
+        frame.children.reserve(len - index.size());
+        auto iIt = index.begin();
+        for (size_t p = 0; p < len; ++p) {
+            if (iIt != index.end() && static_cast<size_t>(*iIt) == p) {
+                ++iIt;
+                continue;
+            }
+            auto cname = std::to_string(p);
+            if (!frame.data.exists(cname) || frame.data.childObjType(cname) != H5O_TYPE_GROUP) {
+                throw std::runtime_error("expected a group at 'data/" + cname + "'");
+            }
+            frame.children.push_back(p);
+        }
+
+        bool named = handle.exists("names");
+        frame.list.reset(Provisioner_::new_List(len, named));
+        if (named) {
+            fill_names(frame.list.get(), handle, len);
+        }
+        if (has_packed) {
+            fill_packed(phandle, index, frame.list.get());
+        }
+
+        return frame;
+    }
+
+    Pointer parse_tree(const H5::Group& handle, const std::string& name) {
+        location = name;
+        auto top = handle.openGroup(name);
+        if (read_string_attribute(top, "uzuki_object") != "list") {
+            throw std::runtime_error("top-level object should be a list");
+        }
+        legacy_version = true;
+        if (top.attrExists("uzuki_version")) {
+            auto vstring = read_string_attribute(top, "uzuki_version");
+            auto version = ritsuko::parse_version_string(vstring.c_str(), vstring.size(), /* skip_patch = */ true);
+            if (version.major != 1) {
+                throw std::runtime_error("unsupported version '" + vstring + "'");
+            }
+            legacy_version = (version.minor == 0);
+        }
+
+        stack.push_back(open_list(top, name, 0));
+        Pointer output = stack.front().list;
+
+        while (!stack.empty()) {
+            auto& frame = stack.back();
+            if (frame.next == frame.children.size()) {
+                auto finished = std::move(frame);
+                stack.pop_back();
+                if (!stack.empty()) {
+                    location = finished.path;
+                    stack.back().list->set(finished.position, finished.list);
+                }
+                continue;
+            }
+
+            size_t position = frame.children[frame.next];
+            ++frame.next;
+            location = frame.path + "/data/" + std::to_string(position);
+            auto chandle = frame.data.openGroup(std::to_string(position));
+            auto object = read_string_attribute(chandle, "uzuki_object");
+
+            if (object == "list") {
+                stack.push_back(open_list(chandle, location, position)); // 'frame' is invalidated after this.
+            } else if (object == "vector") {
+                frame.list->set(position, parse_vector(chandle));
+            } else if (object == "nothing") {
+                frame.list->set(position, Pointer(Provisioner_::new_Nothing()));
+            } else if (object == "external") {
+                frame.list->set(position, parse_external(chandle));
+            } else {
+                throw std::runtime_error("unknown object type '" + object + "'");
+            }
+        }
+
+        return output;
+    }
+
+public:
+    Pointer parse(const H5::Group& handle, const std::string& name) {
+        Pointer output;
+        try {
+            output = parse_tree(handle, name);
+        } catch (H5::Exception& e) {
+            throw std::runtime_error("failed to parse '" + location + "'; " + e.getDetailMsg());
+        } catch (std::exception& e) {
+            throw std::runtime_error("failed to parse '" + location + "'; " + std::string(e.what()));
+        }
+
+        if (num_used_externals != externals.size()) {
+            throw std::runtime_error("number of instances of type \"external\" (" + std::to_string(num_used_externals) +
+                ") does not match the number of external objects (" + std::to_string(externals.size()) + ")");
+        }
+        return output;
+    }
+
+    // Length of the list in 'name', without parsing any of its children.
+    static size_t length(const H5::Group& handle, const std::string& name) {
+        auto ghandle = handle.openGroup(name);
+        size_t len = ghandle.openGroup("data").getNumObjs();
+        if (ghandle.exists("packed")) {
+            len += vector_length(ghandle.openGroup("packed").openDataSet("index"));
+        }
+        return len;
+    }
+};
+
+#endif
@@ -0,0 +1,1277 @@
+#ifndef JSON_LIST_STREAMER_H
+#define JSON_LIST_STREAMER_H
+
+#include "uzuki2/uzuki2.hpp"
+#include "ritsuko/ritsuko.hpp"
+#include "byteme/Reader.hpp"
+#include "JsonPeeker.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <future>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <unordered_set>
+#include <cfloat>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * Event-driven parser for uzuki2 lists in JSON, which validates the structure
+ * as tokens arrive from the reader and passes each completed object straight
+ * to the provisioner. This avoids building a DOM for the entire document, so
+ * memory usage is bounded by the nesting depth plus the largest single vector
+ * (whose values need to be buffered until its length is known). Completed
+ * children are handed over as provisioner objects rather than JSON nodes.
+ *
+ * Object properties may appear in any order, so an object is only created
+ * once its closing brace is reached. For the same reason, the top-level
+ * 'version' may only be known at the very end of the document. We record the
+ * first use of any version-dependent feature and check it against the version
+ * once the top-level object is complete, following the same rules as uzuki2.
+ */
+
+class JsonStreamInput {
+public:
+    JsonStreamInput(byteme::Reader& reader, bool parallel) : reader(reader), parallel(parallel) {
+        if (parallel) {
+            pending = std::async(std::launch::async, [this]() -> bool { return fetch(next); });
+        }
+        refill();
+    }
+
+private:
+    byteme::Reader& reader;
+    bool parallel;
+
+    std::vector<unsigned char> current, next;
+    std::future<bool> pending;
+    const unsigned char* ptr = NULL;
+    size_t len = 0, position = 0, overall = 0;
+    bool remaining = true;
+
+    // Only called on the worker thread when 'parallel = true', so the reader
+    // is never touched by two threads at once.
+    bool fetch(std::vector<unsigned char>& store) {
+        bool more = reader.load();
+        auto buffer = reader.buffer();
+        store.assign(buffer, buffer + reader.available());
+        return more;
+    }
+
+    void refill() {
+        overall += len;
+        position = 0;
+        len = 0;
+
+        // Looping to skip empty chunks from the reader.
+        while (len == 0 && remaining) {
+            if (parallel) {
+                remaining = pending.get();
+                current.swap(next);
+                if (remaining) {
+                    pending = std::async(std::launch::async, [this]() -> bool { return fetch(next); });
+                }
+                ptr = current.data();
+                len = current.size();
+            } else {
+                remaining = reader.load();
+                ptr = reader.buffer();
+                len = reader.available();
+            }
+        }
+    }
+
+public:
+    bool valid() const {
+        return position < len;
+    }
+
+    unsigned char get() const {
+        return ptr[position];
+    }
+
+    bool advance() {
+        ++position;
+        if (position < len) {
+            return true;
+        }
+        refill();
+        return position < len;
+    }
+
+    size_t offset() const {
+        return overall + position;
+    }
+
+    // Direct access to the rest of the current chunk, for scanning a span of
+    // bytes at once rather than going through get() and advance().
+    const unsigned char* chunk_start() const {
+        return ptr + position;
+    }
+
+    const unsigned char* chunk_end() const {
+        return ptr + len;
+    }
+
+    void consume(size_t n) {
+        position += n;
+        if (position >= len) {
+            refill();
+        }
+    }
+};
+
+/**
+ * Helpers for the span-based scanning of strings and numbers. We use SSE2 to
+ * search for the end of each string 16 bytes at a time, and numbers with up
+ * to 15 significant digits are converted exactly without calling strtod().
+ */
+
+inline const unsigned char* find_string_special(const unsigned char* start, const unsigned char* end) {
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\');
+    while (end - start >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(start));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask) {
+            return start + __builtin_ctz(mask);
+        }
+        start += 16;
+    }
+#endif
+    for (; start < end; ++start) {
+        if (*start == '"' || *start == '\\') {
+            break;
+        }
+    }
+    return start;
+}
+
+// Exact by Clinger's fast path, as both the mantissa and the power of 10 are
+// exactly representable and IEEE arithmetic guarantees a correctly rounded
+// product or quotient. This needs strict double evaluation, so it is skipped
+// on platforms with extended-precision intermediates (e.g., x87).
+inline bool fast_decimal_to_double(uint64_t mantissa, int exponent, bool negative, double& output) {
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    if (mantissa > (static_cast<uint64_t>(1) << 53) || exponent < -22 || exponent > 22) {
+        return false;
+    }
+    double value = static_cast<double>(mantissa);
+    value = (exponent < 0 ? value / powers[-exponent] : value * powers[exponent]);
+    output = (negative ? -value : value);
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Checks for the date and date-time formats in the uzuki2 specification,
+// shared with the HDF5 parser.
+inline bool is_date(const std::string& x) {
+    return ritsuko::is_date(x.c_str(), x.size());
+}
+
+inline bool is_rfc3339(const std::string& x) {
+    return ritsuko::is_rfc3339(x.c_str(), x.size());
+}
+
+template<class Provisioner_, class Externals_>
+class JsonListStreamer {
+public:
+    JsonListStreamer(byteme::Reader& reader, Externals_ externals, bool parallel) : input(reader, parallel), externals(std::move(externals)) {}
+
+private:
+    JsonStreamInput input;
+    Externals_ externals;
+    std::vector<size_t> seen_externals;
+
+    // First uses of features that are only valid in version 1.0, or only in
+    // version 1.1 and later, respectively. Empty if no such feature was used.
+    std::string legacy_feature, modern_feature;
+
+    typedef std::shared_ptr<uzuki2::Base> Pointer;
+
+    [[noreturn]] void fail(const std::string& msg, size_t lookahead = 0) const {
+        throw std::runtime_error(msg + " at byte " + std::to_string(input.offset() + lookahead + 1));
+    }
+
+    /** Tokenization. **/
+
+    void skip_whitespace() {
+        while (input.valid()) {
+            auto c = input.get();
+            if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+                break;
+            }
+            input.advance();
+        }
+    }
+
+    unsigned char peek() {
+        if (!input.valid()) {
+            fail("unexpected end of file");
+        }
+        return input.get();
+    }
+
+    void expect(unsigned char c) {
+        if (peek() != c) {
+            fail(std::string("expected '") + static_cast<char>(c) + "'");
+        }
+        input.advance();
+    }
+
+    void expect_literal(const char* rest) {
+        input.advance();
+        for (; *rest; ++rest) {
+            if (!input.valid() || input.get() != static_cast<unsigned char>(*rest)) {
+                fail("invalid literal");
+            }
+            input.advance();
+        }
+    }
+
+    unsigned int parse_hex4() {
+        unsigned int code = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (!input.advance()) {
+                fail("unterminated unicode escape");
+            }
+            auto c = input.get();
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code += c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                code += c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                code += c - 'A' + 10;
+            } else {
+                fail("invalid unicode escape");
+            }
+        }
+        return code;
+    }
+
+    // Assumes that we're currently on the opening quote. Runs of ordinary
+    // characters are appended in bulk, up to the next quote or backslash.
+    void parse_string(std::string& output) {
+        output.clear();
+        input.advance();
+
+        while (true) {
+            if (!input.valid()) {
+                fail("unterminated string");
+            }
+
+            auto start = input.chunk_start(), end = input.chunk_end();
+            auto stop = find_string_special(start, end);
+            output.append(reinterpret_cast<const char*>(start), stop - start);
+            input.consume(stop - start);
+            if (stop == end) {
+                continue;
+            }
+
+            if (input.get() == '"') {
+                input.advance();
+                return;
+            }
+
+            if (!input.advance()) {
+                fail("unterminated string");
+            }
+            auto e = input.get();
+            switch (e) {
+                case '"': case '\\': case '/':
+                    output.push_back(e);
+                    break;
+                case 'b':
+                    output.push_back('\b');
+                    break;
+                case 'f':
+                    output.push_back('\f');
+                    break;
+                case 'n':
+                    output.push_back('\n');
+                    break;
+                case 'r':
+                    output.push_back('\r');
+                    break;
+                case 't':
+                    output.push_back('\t');
+                    break;
+                case 'u':
+                    {
+                        unsigned int code = parse_hex4();
+                        if (code >= 0xD800 && code <= 0xDBFF) {
+                            if (!input.advance() || input.get() != '\\' || !input.advance() || input.get() != 'u') {
+                                fail("unpaired surrogate in unicode escape");
+                            }
+                            unsigned int low = parse_hex4();
+                            if (low < 0xDC00 || low > 0xDFFF) {
+                                fail("invalid low surrogate in unicode escape");
+                            }
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        JsonPeeker::append_utf8(output, code);
+                    }
+                    break;
+                default:
+                    fail("invalid escape sequence");
+            }
+            input.advance();
+        }
+    }
+
+    static bool is_digit(unsigned char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    // Scans a number that lies entirely within the current chunk, returning
+    // the number of bytes used. Zero is returned if the number might continue
+    // into the next chunk, in which case the caller should use the slow path.
+    size_t scan_number(const unsigned char* start, const unsigned char* end, double& output) {
+        auto current = start;
+        bool negative = (*current == '-');
+        if (negative && ++current == end) {
+            return 0;
+        }
+        if (!is_digit(*current)) {
+            fail("invalid number", current - start);
+        }
+
+        uint64_t mantissa = 0;
+        int significant = 0, exponent = 0;
+        auto add_digit = [&](unsigned char c) -> void {
+            if (significant < 19) {
+                mantissa = mantissa * 10 + (c - '0');
+            }
+            if (mantissa) {
+                ++significant;
+            }
+        };
+
+        if (*current == '0') {
+            if (++current == end) {
+                return 0;
+            }
+            if (is_digit(*current)) {
+                fail("leading zeros are not allowed in numbers", current - start);
+            }
+        } else {
+            do {
+                add_digit(*current);
+                if (++current == end) {
+                    return 0;
+                }
+            } while (is_digit(*current));
+        }
+
+        if (*current == '.') {
+            if (++current == end) {
+                return 0;
+            }
+            if (!is_digit(*current)) {
+                fail("expected digits after the decimal point", current - start);
+            }
+            do {
+                add_digit(*current);
+                --exponent;
+                if (++current == end) {
+                    return 0;
+                }
+            } while (is_digit(*current));
+        }
+
+        if (*current == 'e' || *current == 'E') {
+            if (++current == end) {
+                return 0;
+            }
+            bool negative_exponent = (*current == '-');
+            if ((negative_exponent || *current == '+') && ++current == end) {
+                return 0;
+            }
+            if (!is_digit(*current)) {
+                fail("expected digits in the exponent", current - start);
+            }
+            int explicit_exponent = 0;
+            do {
+                if (explicit_exponent < 100000) {
+                    explicit_exponent = explicit_exponent * 10 + (*current - '0');
+                }
+                if (++current == end) {
+                    return 0;
+                }
+            } while (is_digit(*current));
+            exponent += (negative_exponent ? -explicit_exponent : explicit_exponent);
+        }
+
+        if (significant > 19 || !fast_decimal_to_double(mantissa, exponent, negative, output)) {
+            number_buffer.assign(reinterpret_cast<const char*>(start), current - start);
+            output = std::strtod(number_buffer.c_str(), NULL);
+        }
+        return current - start;
+    }
+
+    double parse_number() {
+        peek();
+        double output;
+        size_t used = scan_number(input.chunk_start(), input.chunk_end(), output);
+        if (used) {
+            input.consume(used);
+            return output;
+        }
+        return parse_number_slow();
+    }
+
+    // Validates the JSON number grammar while accumulating the characters for
+    // strtod(), for numbers that span multiple chunks.
+    double parse_number_slow() {
+        number_buffer.clear();
+        bool negative = false;
+        if (peek() == '-') {
+            negative = true;
+            number_buffer.push_back('-');
+            if (!input.advance()) {
+                fail("truncated number");
+            }
+        }
+
+        auto c = peek();
+        if (c < '0' || c > '9') {
+            fail("invalid number");
+        }
+
+        double direct = 0;
+        size_t num_digits = 0;
+        if (c == '0') {
+            number_buffer.push_back('0');
+            input.advance();
+            num_digits = 1;
+            if (input.valid() && input.get() >= '0' && input.get() <= '9') {
+                fail("leading zeros are not allowed in numbers");
+            }
+        } else {
+            do {
+                c = input.get();
+                if (c < '0' || c > '9') {
+                    break;
+                }
+                number_buffer.push_back(c);
+                direct = direct * 10 + (c - '0');
+                ++num_digits;
+            } while (input.advance());
+        }
+
+        bool simple = true;
+        if (input.valid() && input.get() == '.') {
+            simple = false;
+            number_buffer.push_back('.');
+            if (!input.advance() || input.get() < '0' || input.get() > '9') {
+                fail("expected digits after the decimal point");
+            }
+            do {
+                c = input.get();
+                if (c < '0' || c > '9') {
+                    break;
+                }
+                number_buffer.push_back(c);
+            } while (input.advance());
+        }
+
+        if (input.valid() && (input.get() == 'e' || input.get() == 'E')) {
+            simple = false;
+            number_buffer.push_back('e');
+            if (!input.advance()) {
+                fail("truncated exponent");
+            }
+            c = input.get();
+            if (c == '+' || c == '-') {
+                number_buffer.push_back(c);
+                if (!input.advance()) {
+                    fail("truncated exponent");
+                }
+            }
+            if (input.get() < '0' || input.get() > '9') {
+                fail("expected digits in the exponent");
+            }
+            do {
+                c = input.get();
+                if (c < '0' || c > '9') {
+                    break;
+                }
+                number_buffer.push_back(c);
+            } while (input.advance());
+        }
+
+        if (simple && num_digits <= 15) {
+            return (negative ? -direct : direct);
+        }
+        return std::strtod(number_buffer.c_str(), NULL);
+    }
+
+    std::string number_buffer;
+
+    // Skips over an arbitrary value for properties that we don't care about.
+    // Only the brackets are matched, with an explicit stack of the expected
+    // closing brackets so that deeply nested values are not a problem.
+    void skip_value() {
+        std::vector<unsigned char> closers;
+        do {
+            skip_whitespace();
+            auto c = peek();
+            if (c == '{' || c == '[') {
+                closers.push_back(c == '{' ? '}' : ']');
+                input.advance();
+            } else if (c == '}' || c == ']') {
+                if (closers.empty() || closers.back() != c) {
+                    fail("mismatched brackets");
+                }
+                closers.pop_back();
+                input.advance();
+            } else if (c == ',' || c == ':') {
+                if (closers.empty()) {
+                    fail("unexpected delimiter");
+                }
+                input.advance();
+            } else if (c == '"') {
+                parse_string(scratch);
+            } else if (c == 't') {
+                expect_literal("rue");
+            } else if (c == 'f') {
+                expect_literal("alse");
+            } else if (c == 'n') {
+                expect_literal("ull");
+            } else {
+                parse_number();
+            }
+        } while (!closers.empty());
+    }
+
+    std::string scratch;
+
+    template<class Function_>
+    size_t scan_array(Function_ fun) {
+        expect('[');
+        skip_whitespace();
+        if (peek() == ']') {
+            input.advance();
+            return 0;
+        }
+
+        size_t count = 0;
+        while (true) {
+            skip_whitespace();
+            fun();
+            ++count;
+
+            skip_whitespace();
+            auto next = peek();
+            if (next == ']') {
+                input.advance();
+                break;
+            } else if (next != ',') {
+                fail("expected ',' or ']' after an array value");
+            }
+            input.advance();
+        }
+
+        return count;
+    }
+
+    /** Buffering the properties of each object. **/
+
+    enum ValueKind : unsigned char { NUL, NUMBER, STRING, TRUE, FALSE, OBJECT };
+
+    // Values are stored in the order of arrival, with one vector per kind so
+    // that numbers don't pay for the size of a std::string.
+    struct ValueBuffer {
+        std::vector<unsigned char> kinds;
+        std::vector<double> numbers;
+        std::vector<std::string> strings;
+        std::vector<Pointer> children;
+
+        size_t size() const {
+            return kinds.size();
+        }
+    };
+
+    struct PendingObject {
+        bool has_type = false;
+        std::string type;
+
+        bool has_values = false;
+        bool scalar = false;
+        ValueBuffer values;
+
+        bool has_names = false;
+        std::vector<std::string> names;
+
+        bool has_levels = false;
+        std::vector<std::string> levels;
+
+        bool has_ordered = false;
+        bool ordered = false;
+
+        bool has_format = false;
+        std::string format;
+
+        bool has_index = false;
+        double index = 0;
+
+        bool has_version = false;
+        std::string version;
+    };
+
+    void parse_primitive(ValueBuffer& buffer) {
+        auto c = peek();
+        if (c == '"') {
+            buffer.strings.emplace_back();
+            parse_string(buffer.strings.back());
+            buffer.kinds.push_back(STRING);
+        } else if (c == 't') {
+            expect_literal("rue");
+            buffer.kinds.push_back(TRUE);
+        } else if (c == 'f') {
+            expect_literal("alse");
+            buffer.kinds.push_back(FALSE);
+        } else if (c == 'n') {
+            expect_literal("ull");
+            buffer.kinds.push_back(NUL);
+        } else if (c == '[') {
+            fail("nested arrays are not supported in 'values'");
+        } else {
+            buffer.numbers.push_back(parse_number());
+            buffer.kinds.push_back(NUMBER);
+        }
+    }
+
+    void parse_string_array(std::vector<std::string>& output, const char* property) {
+        if (peek() != '[') {
+            fail("expected an array for '" + std::string(property) + "'");
+        }
+        scan_array([&]() -> void {
+            if (peek() != '"') {
+                fail("expected strings in '" + std::string(property) + "'");
+            }
+            output.emplace_back();
+            parse_string(output.back());
+        });
+    }
+
+    void check_duplicate(bool present, const std::string& key) {
+        if (present) {
+            fail("duplicate '" + key + "' property");
+        }
+    }
+
+    // Parses the value of any property other than 'values'.
+    void parse_property(PendingObject& pending, const std::string& key, bool top) {
+        if (key == "type") {
+            check_duplicate(pending.has_type, key);
+            if (peek() != '"') {
+                fail("expected a string for 'type'");
+            }
+            parse_string(pending.type);
+            pending.has_type = true;
+
+        } else if (key == "names") {
+            check_duplicate(pending.has_names, key);
+            parse_string_array(pending.names, "names");
+            pending.has_names = true;
+
+        } else if (key == "levels") {
+            check_duplicate(pending.has_levels, key);
+            parse_string_array(pending.levels, "levels");
+            pending.has_levels = true;
+
+        } else if (key == "ordered") {
+            check_duplicate(pending.has_ordered, key);
+            auto c = peek();
+            if (c == 't') {
+                expect_literal("rue");
+                pending.ordered = true;
+            } else if (c == 'f') {
+                expect_literal("alse");
+                pending.ordered = false;
+            } else {
+                fail("expected a boolean for 'ordered'");
+            }
+            pending.has_ordered = true;
+
+        } else if (key == "format") {
+            check_duplicate(pending.has_format, key);
+            if (peek() != '"') {
+                fail("expected a string for 'format'");
+            }
+            parse_string(pending.format);
+            pending.has_format = true;
+
+        } else if (key == "index") {
+            check_duplicate(pending.has_index, key);
+            auto c = peek();
+            if (c != '-' && (c < '0' || c > '9')) {
+                fail("expected a number for 'index'");
+            }
+            pending.index = parse_number();
+            pending.has_index = true;
+
+        } else if (key == "version" && top) {
+            check_duplicate(pending.has_version, key);
+            if (peek() != '"') {
+                fail("expected a string for 'version'");
+            }
+            parse_string(pending.version);
+            pending.has_version = true;
+
+        } else {
+            skip_value();
+        }
+    }
+
+    /** Walking through the nested objects. **/
+
+    // Where we are in each object, as nested lists are handled with an explicit
+    // stack rather than by recursion. This means that the C stack usage does
+    // not depend on the depth of the list.
+    enum ParseState { OBJECT_START, OBJECT_KEY, OBJECT_NEXT, VALUES_START, VALUES_ELEMENT, VALUES_NEXT };
+
+    struct Frame {
+        PendingObject pending;
+        ParseState state = OBJECT_START;
+    };
+
+    std::vector<Frame> stack;
+
+    Pointer parse_tree() {
+        skip_whitespace();
+        if (peek() != '{') {
+            fail("expected an object");
+        }
+        input.advance();
+        stack.emplace_back();
+
+        std::string key;
+        while (true) {
+            skip_whitespace();
+            auto& frame = stack.back();
+            auto& pending = frame.pending;
+
+            switch (frame.state) {
+                case OBJECT_START:
+                    if (peek() == '}') {
+                        input.advance();
+                        if (auto output = finish_object()) {
+                            return output;
+                        }
+                        break;
+                    }
+                    // fall through
+                case OBJECT_KEY:
+                    if (peek() != '"') {
+                        fail("expected a string for the object key");
+                    }
+                    parse_string(key);
+                    skip_whitespace();
+                    expect(':');
+                    skip_whitespace();
+
+                    frame.state = OBJECT_NEXT;
+                    if (key != "values") {
+                        parse_property(pending, key, stack.size() == 1);
+                    } else {
+                        check_duplicate(pending.has_values, key);
+                        pending.has_values = true;
+                        auto c = peek();
+                        if (c == '[') {
+                            input.advance();
+                            frame.state = VALUES_START;
+                        } else if (c == '{') {
+                            fail("expected an array for 'values'");
+                        } else {
+                            pending.scalar = true;
+                            parse_primitive(pending.values);
+                        }
+                    }
+                    break;
+
+                case OBJECT_NEXT:
+                    {
+                        auto c = peek();
+                        input.advance();
+                        if (c == ',') {
+                            frame.state = OBJECT_KEY;
+                        } else if (c == '}') {
+                            if (auto output = finish_object()) {
+                                return output;
+                            }
+                        } else {
+                            fail("expected ',' or '}' after an object value");
+                        }
+                    }
+                    break;
+
+                case VALUES_START:
+                    if (peek() == ']') {
+                        input.advance();
+                        frame.state = OBJECT_NEXT;
+                        break;
+                    }
+                    // fall through
+                case VALUES_ELEMENT:
+                    frame.state = VALUES_NEXT;
+                    if (peek() == '{') {
+                        input.advance();
+                        stack.emplace_back(); // invalidates 'frame', so this must be last.
+                    } else {
+                        // If the type is already known, non-list elements can be rejected early.
+                        if (pending.has_type && pending.type == "list") {
+                            fail("expected objects in 'values' for a list");
+                        }
+                        parse_primitive(pending.values);
+                    }
+                    break;
+
+                case VALUES_NEXT:
+                    {
+                        auto c = peek();
+                        input.advance();
+                        if (c == ',') {
+                            frame.state = VALUES_ELEMENT;
+                        } else if (c == ']') {
+                            frame.state = OBJECT_NEXT;
+                        } else {
+                            fail("expected ',' or ']' after an array value");
+                        }
+                    }
+                    break;
+            }
+        }
+    }
+
+    // Creates the object for the innermost frame and hands it to the parent,
+    // returning it if it was the top-level object.
+    Pointer finish_object() {
+        auto& pending = stack.back().pending;
+        auto output = build(pending);
+        if (stack.size() == 1) {
+            check_version(pending);
+        }
+        stack.pop_back();
+
+        if (stack.empty()) {
+            return output;
+        }
+        auto& values = stack.back().pending.values;
+        values.children.push_back(std::move(output));
+        values.kinds.push_back(OBJECT);
+        return Pointer();
+    }
+
+    // Reports the position of the failing object within its parent lists.
+    // For very deep lists, only the outermost and innermost levels are shown.
+    std::string describe_location() const {
+        std::string location;
+        size_t depth = stack.size(), shown = 10;
+        for (size_t s = 1; s < depth; ++s) {
+            if (depth > 2 * shown && s == shown + 1) {
+                location += "... (" + std::to_string(depth - 2 * shown - 1) + " more levels) ...: ";
+                s = depth - shown - 1;
+                continue;
+            }
+            location += "list element " + std::to_string(stack[s - 1].pending.values.size() + 1) + ": ";
+        }
+        return location;
+    }
+
+    void note_legacy(const std::string& feature) {
+        if (legacy_feature.empty()) {
+            legacy_feature = describe_location() + feature;
+        }
+    }
+
+    void note_modern(const std::string& feature) {
+        if (modern_feature.empty()) {
+            modern_feature = describe_location() + feature;
+        }
+    }
+
+    // Lists without a 'version' are assumed to be version 1.0.
+    void check_version(const PendingObject& pending) const {
+        bool legacy = true;
+        if (pending.has_version) {
+            auto version = ritsuko::parse_version_string(pending.version.c_str(), pending.version.size(), /* skip_patch = */ true);
+            if (version.major != 1) {
+                throw std::runtime_error("unsupported version '" + pending.version + "'");
+            }
+            legacy = (version.minor == 0);
+        }
+
+        if (legacy && !modern_feature.empty()) {
+            throw std::runtime_error(modern_feature + " requires version 1.1 or later");
+        }
+        if (!legacy && !legacy_feature.empty()) {
+            throw std::runtime_error(legacy_feature + " is only supported in version 1.0");
+        }
+    }
+
+    /** Creating the objects. **/
+
+    static bool is_integral(double x) {
+        return std::isfinite(x) && x == std::trunc(x);
+    }
+
+    template<class Vector_>
+    void fill_names(Vector_* ptr, const PendingObject& pending) {
+        if (pending.has_names) {
+            for (size_t i = 0, end = pending.names.size(); i < end; ++i) {
+                ptr->set_name(i, pending.names[i]);
+            }
+        }
+    }
+
+    [[noreturn]] static void fail_value(const std::string& type, size_t i, const std::string& expected) {
+        throw std::runtime_error("expected " + expected + " in 'values' for type \"" + type + "\" (element " + std::to_string(i + 1) + ")");
+    }
+
+    Pointer build_list(const PendingObject& pending) {
+        if (!pending.has_values || pending.scalar) {
+            throw std::runtime_error("expected an array for 'values' in a list");
+        }
+
+        const auto& values = pending.values;
+        size_t n = values.size();
+        if (values.children.size() != n) {
+            throw std::runtime_error("expected objects in 'values' for a list");
+        }
+        if (pending.has_names && pending.names.size() != n) {
+            throw std::runtime_error("length of 'names' and 'values' should be the same for type \"list\"");
+        }
+
+        std::shared_ptr<uzuki2::List> ptr(Provisioner_::new_List(n, pending.has_names));
+        for (size_t i = 0; i < n; ++i) {
+            ptr->set(i, values.children[i]);
+        }
+        fill_names(ptr.get(), pending);
+        return ptr;
+    }
+
+    Pointer build_factor(const PendingObject& pending, size_t n) {
+        if (!pending.has_levels) {
+            throw std::runtime_error("expected a 'levels' property for type \"" + pending.type + "\"");
+        }
+
+        const auto& levels = pending.levels;
+        {
+            std::unordered_set<std::string> observed;
+            observed.reserve(levels.size());
+            for (const auto& l : levels) {
+                if (!observed.insert(l).second) {
+                    throw std::runtime_error("duplicate level '" + l + "' for type \"" + pending.type + "\"");
+                }
+            }
+        }
+
+        if (pending.type == "ordered") {
+            note_legacy("type \"ordered\"");
+        }
+        if (pending.has_ordered) {
+            note_modern("'ordered' property");
+        }
+        bool ordered = (pending.has_ordered ? pending.ordered : pending.type == "ordered");
+        std::shared_ptr<uzuki2::Factor> ptr(Provisioner_::new_Factor(n, pending.has_names, pending.scalar, levels.size(), ordered));
+
+        const auto& values = pending.values;
+        size_t ndex = 0;
+        double nlevels = levels.size();
+        for (size_t i = 0; i < n; ++i) {
+            auto k = values.kinds[i];
+            if (k == NUL) {
+                ptr->set_missing(i);
+            } else if (k == NUMBER) {
+                double val = values.numbers[ndex++];
+                if (!is_integral(val) || val < 0 || val >= nlevels) {
+                    fail_value(pending.type, i, "integer codes in [0, " + std::to_string(levels.size()) + ")");
+                }
+                ptr->set(i, static_cast<size_t>(val));
+            } else {
+                fail_value(pending.type, i, "integer codes or null");
+            }
+        }
+
+        for (size_t l = 0; l < levels.size(); ++l) {
+            ptr->set_level(l, levels[l]);
+        }
+        fill_names(ptr.get(), pending);
+        return ptr;
+    }
+
+    Pointer build(PendingObject& pending) {
+        if (!pending.has_type) {
+            throw std::runtime_error("missing 'type' property");
+        }
+        const auto& type = pending.type;
+
+        if (type == "nothing") {
+            return Pointer(Provisioner_::new_Nothing());
+        }
+
+        if (type == "external") {
+            if (!pending.has_index) {
+                throw std::runtime_error("expected an 'index' property for type \"external\"");
+            }
+            double index = pending.index;
+            if (!is_integral(index) || index < 0 || index >= static_cast<double>(externals.size())) {
+                throw std::runtime_error("'index' for type \"external\" should be an integer in [0, " + std::to_string(externals.size()) + ")");
+            }
+            seen_externals.push_back(index);
+            return Pointer(Provisioner_::new_External(externals.get(index)));
+        }
+
+        if (type == "list") {
+            return build_list(pending);
+        }
+
+        if (!pending.has_values) {
+            throw std::runtime_error("expected a 'values' property for type \"" + type + "\"");
+        }
+        auto& values = pending.values;
+        size_t n = values.size();
+        if (pending.has_names && pending.names.size() != n) {
+            throw std::runtime_error("length of 'names' and 'values' should be the same for type \"" + type + "\"");
+        }
+        if (!values.children.empty()) {
+            throw std::runtime_error("unexpected objects in 'values' for type \"" + type + "\"");
+        }
+
+        if (type == "factor" || type == "ordered") {
+            return build_factor(pending, n);
+        }
+
+        size_t ndex = 0, sdex = 0;
+
+        if (type == "integer") {
+            std::shared_ptr<uzuki2::IntegerVector> ptr(Provisioner_::new_Integer(n, pending.has_names, pending.scalar));
+            for (size_t i = 0; i < n; ++i) {
+                auto k = values.kinds[i];
+                if (k == NUL) {
+                    ptr->set_missing(i);
+                } else if (k == NUMBER) {
+                    double val = values.numbers[ndex++];
+                    if (!is_integral(val) || val < -2147483648.0 || val > 2147483647.0) {
+                        fail_value(type, i, "32-bit integers");
+                    }
+                    ptr->set(i, static_cast<int32_t>(val));
+                } else {
+                    fail_value(type, i, "numbers or null");
+                }
+            }
+            fill_names(ptr.get(), pending);
+            return ptr;
+        }
+
+        if (type == "number") {
+            std::shared_ptr<uzuki2::NumberVector> ptr(Provisioner_::new_Number(n, pending.has_names, pending.scalar));
+            for (size_t i = 0; i < n; ++i) {
+                auto k = values.kinds[i];
+                if (k == NUL) {
+                    ptr->set_missing(i);
+                } else if (k == NUMBER) {
+                    ptr->set(i, values.numbers[ndex++]);
+                } else if (k == STRING) {
+                    const auto& s = values.strings[sdex++];
+                    note_modern("string \"" + s + "\" in type \"number\"");
+                    if (s == "NaN") {
+                        ptr->set(i, std::numeric_limits<double>::quiet_NaN());
+                    } else if (s == "Inf") {
+                        ptr->set(i, std::numeric_limits<double>::infinity());
+                    } else if (s == "-Inf") {
+                        ptr->set(i, -std::numeric_limits<double>::infinity());
+                    } else {
+                        fail_value(type, i, "numbers, null or the strings \"NaN\", \"Inf\" and \"-Inf\"");
+                    }
+                } else {
+                    fail_value(type, i, "numbers or null");
+                }
+            }
+            fill_names(ptr.get(), pending);
+            return ptr;
+        }
+
+        if (type == "boolean") {
+            std::shared_ptr<uzuki2::BooleanVector> ptr(Provisioner_::new_Boolean(n, pending.has_names, pending.scalar));
+            for (size_t i = 0; i < n; ++i) {
+                auto k = values.kinds[i];
+                if (k == NUL) {
+                    ptr->set_missing(i);
+                } else if (k == TRUE || k == FALSE) {
+                    ptr->set(i, k == TRUE);
+                } else {
+                    fail_value(type, i, "booleans or null");
+                }
+            }
+            fill_names(ptr.get(), pending);
+            return ptr;
+        }
+
+        if (type == "string" || type == "date" || type == "date-time") {
+            if (type != "string") {
+                note_legacy("type \"" + type + "\"");
+            }
+            if (pending.has_format) {
+                note_modern("'format' property");
+            }
+
+            auto format = uzuki2::StringVector::NONE;
+            const std::string& fstr = (pending.has_format ? pending.format : type);
+            if (fstr == "date") {
+                format = uzuki2::StringVector::DATE;
+            } else if (fstr == "date-time") {
+                format = uzuki2::StringVector::DATETIME;
+            } else if (pending.has_format) {
+                throw std::runtime_error("unsupported format '" + pending.format + "' for type \"string\"");
+            }
+
+            std::shared_ptr<uzuki2::StringVector> ptr(Provisioner_::new_String(n, pending.has_names, pending.scalar, format));
+            for (size_t i = 0; i < n; ++i) {
+                auto k = values.kinds[i];
+                if (k == NUL) {
+                    ptr->set_missing(i);
+                } else if (k == STRING) {
+                    auto& s = values.strings[sdex++];
+                    if (format == uzuki2::StringVector::DATE && !is_date(s)) {
+                        fail_value(type, i, "dates in YYYY-MM-DD format");
+                    } else if (format == uzuki2::StringVector::DATETIME && !is_rfc3339(s)) {
+                        fail_value(type, i, "Internet date/times");
+                    }
+                    ptr->set(i, std::move(s));
+                } else {
+                    fail_value(type, i, "strings or null");
+                }
+            }
+            fill_names(ptr.get(), pending);
+            return ptr;
+        }
+
+        throw std::runtime_error("unknown object type \"" + type + "\"");
+    }
+
+public:
+    Pointer parse() {
+        Pointer output;
+        try {
+            output = parse_tree();
+        } catch (std::exception& e) {
+            throw std::runtime_error(describe_location() + std::string(e.what()));
+        }
+
+        skip_whitespace();
+        if (input.valid()) {
+            fail("unexpected trailing characters after the top-level object");
+        }
+
+        // Each external object should be referenced exactly once.
+        if (seen_externals.size() != externals.size()) {
+            throw std::runtime_error("number of instances of type \"external\" (" + std::to_string(seen_externals.size()) +
+                ") does not match the number of external objects (" + std::to_string(externals.size()) + ")");
+        }
+        std::vector<unsigned char> used(externals.size());
+        for (auto i : seen_externals) {
+            if (used[i]) {
+                throw std::runtime_error("multiple instances of type \"external\" with index " + std::to_string(i));
+            }
+            used[i] = true;
+        }
+
+        return output;
+    }
+};
+
+/**
+ * Provisioner that discards all values, for validation only.
+ */
+
+struct JsonValidationProvisioner {
+    template<class Base_>
+    struct Vector : public Base_ {
+        Vector(size_t l) : length(l) {}
+        size_t length;
+        size_t size() const { return length; }
+        void set_missing(size_t) {}
+        void set_name(size_t, std::string) {}
+    };
+
+    struct Integer : public Vector<uzuki2::IntegerVector> {
+        using Vector::Vector;
+        void set(size_t, int32_t) {}
+    };
+
+    struct Number : public Vector<uzuki2::NumberVector> {
+        using Vector::Vector;
+        void set(size_t, double) {}
+    };
+
+    struct Boolean : public Vector<uzuki2::BooleanVector> {
+        using Vector::Vector;
+        void set(size_t, bool) {}
+    };
+
+    struct String : public Vector<uzuki2::StringVector> {
+        using Vector::Vector;
+        void set(size_t, std::string) {}
+    };
+
+    struct Factor : public Vector<uzuki2::Factor> {
+        using Vector::Vector;
+        void set(size_t, size_t) {}
+        void set_level(size_t, std::string) {}
+    };
+
+    struct List : public uzuki2::List {
+        List(size_t l) : length(l) {}
+        size_t length;
+        size_t size() const { return length; }
+        void set(size_t, std::shared_ptr<uzuki2::Base>) {}
+        void set_name(size_t, std::string) {}
+    };
+
+    struct Nothing : public uzuki2::Nothing {};
+
+    struct External : public uzuki2::External {};
+
+    static uzuki2::Nothing* new_Nothing() { return new Nothing; }
+
+    static uzuki2::External* new_External(void*) { return new External; }
+
+    static uzuki2::List* new_List(size_t l, bool) { return new List(l); }
+
+    static uzuki2::IntegerVector* new_Integer(size_t l, bool, bool) { return new Integer(l); }
+
+    static uzuki2::NumberVector* new_Number(size_t l, bool, bool) { return new Number(l); }
+
+    static uzuki2::BooleanVector* new_Boolean(size_t l, bool, bool) { return new Boolean(l); }
+
+    static uzuki2::StringVector* new_String(size_t l, bool, bool, uzuki2::StringVector::Format) { return new String(l); }
+
+    static uzuki2::Factor* new_Factor(size_t l, bool, bool, size_t, bool) { return new Factor(l); }
+};
+
+struct JsonValidationExternals {
+    JsonValidationExternals(size_t n) : number(n) {}
+    size_t number;
+    void* get(size_t) const { return NULL; }
+    size_t size() const { return number; }
+};
+
+#endif
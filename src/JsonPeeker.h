@@ -0,0 +1,276 @@
+#ifndef JSON_PEEKER_H
+#define JSON_PEEKER_H
+
+#include <string>
+#include <stdexcept>
+
+/**
+ * Minimal JSON scanner for pulling out a handful of values from a document
+ * without constructing a representation of the entire thing. Values that are
+ * not of interest are skipped by only tracking the nesting depth.
+ */
+
+class JsonPeeker {
+public:
+    JsonPeeker(const std::string& contents) : buffer(contents) {}
+
+private:
+    const std::string& buffer;
+    size_t position = 0;
+
+public:
+    [[noreturn]] void fail(const std::string& msg) const {
+        throw std::runtime_error(msg + " at position " + std::to_string(position + 1));
+    }
+
+    void skip_whitespace() {
+        while (position < buffer.size()) {
+            char c = buffer[position];
+            if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+                break;
+            }
+            ++position;
+        }
+    }
+
+    char peek() {
+        if (position >= buffer.size()) {
+            fail("unexpected end of file");
+        }
+        return buffer[position];
+    }
+
+    void expect(char c) {
+        if (peek() != c) {
+            fail(std::string("expected '") + c + "'");
+        }
+        ++position;
+    }
+
+    static void append_utf8(std::string& output, unsigned int code) {
+        if (code < 0x80) {
+            output += static_cast<char>(code);
+        } else if (code < 0x800) {
+            output += static_cast<char>(0xC0 | (code >> 6));
+            output += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            output += static_cast<char>(0xE0 | (code >> 12));
+            output += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            output += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            output += static_cast<char>(0xF0 | (code >> 18));
+            output += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            output += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            output += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    unsigned int parse_hex4() {
+        if (position + 4 > buffer.size()) {
+            fail("unterminated unicode escape");
+        }
+        unsigned int code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = buffer[position++];
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code += c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                code += c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                code += c - 'A' + 10;
+            } else {
+                fail("invalid unicode escape");
+            }
+        }
+        return code;
+    }
+
+    // Assumes that we're currently on the opening quote.
+    void parse_string(std::string* output) {
+        ++position;
+        while (true) {
+            if (position >= buffer.size()) {
+                fail("unterminated string");
+            }
+
+            char c = buffer[position++];
+            if (c == '"') {
+                return;
+            }
+            if (c != '\\') {
+                if (output) {
+                    output->push_back(c);
+                }
+                continue;
+            }
+
+            if (position >= buffer.size()) {
+                fail("unterminated string");
+            }
+            char e = buffer[position++];
+            if (e == 'u') {
+                unsigned int code = parse_hex4();
+                if (code >= 0xD800 && code <= 0xDBFF && position + 1 < buffer.size() && buffer[position] == '\\' && buffer[position + 1] == 'u') {
+                    position += 2;
+                    unsigned int low = parse_hex4();
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                if (output) {
+                    append_utf8(*output, code);
+                }
+                continue;
+            }
+
+            if (output) {
+                switch (e) {
+                    case '"': case '\\': case '/':
+                        output->push_back(e);
+                        break;
+                    case 'b':
+                        output->push_back('\b');
+                        break;
+                    case 'f':
+                        output->push_back('\f');
+                        break;
+                    case 'n':
+                        output->push_back('\n');
+                        break;
+                    case 'r':
+                        output->push_back('\r');
+                        break;
+                    case 't':
+                        output->push_back('\t');
+                        break;
+                    default:
+                        fail("invalid escape sequence");
+                }
+            }
+        }
+    }
+
+    // Skips over an arbitrary value, only tracking nesting depth.
+    void skip_value() {
+        skip_whitespace();
+        char c = peek();
+        if (c == '"') {
+            parse_string(NULL);
+            return;
+        }
+
+        if (c != '{' && c != '[') {
+            // Scalars (numbers, true/false/null) run until the next delimiter.
+            while (position < buffer.size()) {
+                char d = buffer[position];
+                if (d == ',' || d == '}' || d == ']' || d == ' ' || d == '\n' || d == '\r' || d == '\t') {
+                    break;
+                }
+                ++position;
+            }
+            return;
+        }
+
+        size_t depth = 0;
+        while (true) {
+            if (position >= buffer.size()) {
+                fail("unterminated object or array");
+            }
+            char d = buffer[position];
+            if (d == '"') {
+                parse_string(NULL);
+                continue;
+            }
+            ++position;
+            if (d == '{' || d == '[') {
+                ++depth;
+            } else if (d == '}' || d == ']') {
+                --depth;
+                if (depth == 0) {
+                    return;
+                }
+            }
+        }
+    }
+
+    bool consume_literal(const char* literal, size_t len) {
+        if (buffer.compare(position, len, literal) == 0) {
+            position += len;
+            return true;
+        }
+        return false;
+    }
+
+    // Iterates over the key/value pairs of an object, assuming that we're
+    // currently on (or before) the opening brace. 'fun' is called with each key
+    // and should consume the associated value.
+    template<class Function>
+    void scan_object(Function fun) {
+        skip_whitespace();
+        expect('{');
+        skip_whitespace();
+        if (peek() == '}') {
+            ++position;
+            return;
+        }
+
+        std::string key;
+        while (true) {
+            skip_whitespace();
+            if (peek() != '"') {
+                fail("expected a string for the object key");
+            }
+            key.clear();
+            parse_string(&key);
+            skip_whitespace();
+            expect(':');
+            skip_whitespace();
+
+            fun(key);
+
+            skip_whitespace();
+            char next = peek();
+            ++position;
+            if (next == '}') {
+                break;
+            } else if (next != ',') {
+                --position;
+                fail("expected ',' or '}' after an object value");
+            }
+        }
+    }
+
+    // Iterates over the elements of an array, assuming that we're currently on
+    // (or before) the opening bracket. 'fun' should consume each element.
+    // Returns the number of elements in the array.
+    template<class Function>
+    size_t scan_array(Function fun) {
+        skip_whitespace();
+        expect('[');
+        skip_whitespace();
+        if (peek() == ']') {
+            ++position;
+            return 0;
+        }
+
+        size_t count = 0;
+        while (true) {
+            skip_whitespace();
+            fun();
+            ++count;
+
+            skip_whitespace();
+            char next = peek();
+            ++position;
+            if (next == ']') {
+                break;
+            } else if (next != ',') {
+                --position;
+                fail("expected ',' or ']' after an array value");
+            }
+        }
+
+        return count;
+    }
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef PAGED_HDF5_FILE_H
+#define PAGED_HDF5_FILE_H
+
+#include "H5Cpp.h"
+#include <string>
+
+/**
+ * Support for HDF5 files that use the paged file space strategy, where both
+ * metadata and raw data are aggregated into fixed-size pages. Readers of such
+ * files can enable the page buffer so that the metadata is fetched in a
+ * handful of large aligned reads rather than many small scattered reads,
+ * which is much faster on network and parallel file systems.
+ */
+
+constexpr size_t hdf5_page_buffer_size = 4194304;
+
+// HDF5 refuses to enable the page buffer for files that are not paged, so we
+// first open the file normally and inspect its file space strategy. Only
+// paged files are then re-opened with the page buffer; the initial open only
+// reads the superblock, so this is cheap compared to the reads it saves.
+inline H5::H5File open_hdf5_file(const std::string& path) {
+    H5::H5File plain(path, H5F_ACC_RDONLY);
+
+    bool paged = false;
+    {
+        auto fcpl = plain.getCreatePlist();
+        H5F_fspace_strategy_t strategy;
+        hbool_t persist;
+        hsize_t threshold;
+        if (H5Pget_file_space_strategy(fcpl.getId(), &strategy, &persist, &threshold) >= 0) {
+            paged = (strategy == H5F_FSPACE_STRATEGY_PAGE);
+        }
+    }
+    if (!paged) {
+        return plain;
+    }
+
+    H5::FileAccPropList fapl;
+    if (H5Pset_page_buffer_size(fapl.getId(), hdf5_page_buffer_size, 0, 0) < 0) {
+        return plain;
+    }
+    plain.close();
+    return H5::H5File(path, H5F_ACC_RDONLY, H5::FileCreatPropList::DEFAULT, fapl);
+}
+
+#endif
@@ -0,0 +1,332 @@
+#ifndef PARALLEL_CHUNK_READER_H
+#define PARALLEL_CHUNK_READER_H
+
+#include "H5Cpp.h"
+#include "zlib.h"
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+
+/**
+ * Reading a chunked 1-dimensional numeric dataset with parallel decompression.
+ * HDF5 is not thread-safe, so the raw (still compressed) chunks are fetched
+ * with H5Dread_chunk() on the calling thread. Each chunk is then inflated,
+ * unshuffled and converted by a pool of worker threads, which write directly
+ * into the destination buffer. This only supports the shuffle and deflate
+ * filters, i.e., the ones used by h5_create_vector(); all other datasets
+ * should be read through the usual HDF5 filter pipeline instead.
+ */
+
+namespace parallel_chunks {
+
+enum class Kind { UNSUPPORTED, SIGNED, UNSIGNED, FLOAT };
+
+struct Layout {
+    Kind kind = Kind::UNSUPPORTED;
+    size_t type_size = 0;
+    hsize_t length = 0;
+    hsize_t chunk_length = 0;
+    hsize_t num_chunks = 0;
+
+    // Position of each filter in the pipeline, or -1 if absent.
+    int shuffle = -1;
+    int deflate = -1;
+
+    // Whether the values should be returned as doubles rather than ints.
+    bool as_double() const {
+        return kind == Kind::FLOAT || (kind == Kind::UNSIGNED && type_size == 4);
+    }
+};
+
+inline Layout inspect(const H5::DataSet& dhandle) {
+    Layout output, unsupported;
+
+    auto dtype = dhandle.getDataType();
+    auto cls = dtype.getClass();
+    output.type_size = dtype.getSize();
+    if (cls == H5T_INTEGER) {
+        H5::IntType itype(dhandle);
+        if (itype.getOrder() != H5::PredType::NATIVE_INT.getOrder()) {
+            return unsupported;
+        }
+        if (output.type_size != 1 && output.type_size != 2 && output.type_size != 4) {
+            return unsupported;
+        }
+        output.kind = (itype.getSign() == H5T_SGN_NONE ? Kind::UNSIGNED : Kind::SIGNED);
+    } else if (cls == H5T_FLOAT) {
+        H5::FloatType ftype(dhandle);
+        if (ftype.getOrder() != H5::PredType::NATIVE_DOUBLE.getOrder()) {
+            return unsupported;
+        }
+        if (!(ftype == H5::PredType::IEEE_F32LE || ftype == H5::PredType::IEEE_F32BE || ftype == H5::PredType::IEEE_F64LE || ftype == H5::PredType::IEEE_F64BE)) {
+            return unsupported;
+        }
+        output.kind = Kind::FLOAT;
+    } else {
+        return unsupported;
+    }
+
+    auto dspace = dhandle.getSpace();
+    if (dspace.getSimpleExtentNdims() != 1) {
+        return unsupported;
+    }
+    dspace.getSimpleExtentDims(&(output.length));
+
+    auto dcpl = dhandle.getCreatePlist();
+    if (dcpl.getLayout() != H5D_CHUNKED) {
+        return unsupported;
+    }
+    dcpl.getChunk(1, &(output.chunk_length));
+    if (output.chunk_length == 0) {
+        return unsupported;
+    }
+
+    int nfilters = dcpl.getNfilters();
+    for (int f = 0; f < nfilters; ++f) {
+        unsigned int flags;
+        size_t nelmts = 0;
+        unsigned int config;
+        auto id = H5Pget_filter2(dcpl.getId(), f, &flags, &nelmts, NULL, 0, NULL, &config);
+        if (id == H5Z_FILTER_SHUFFLE && output.shuffle < 0 && output.deflate < 0) {
+            output.shuffle = f;
+        } else if (id == H5Z_FILTER_DEFLATE && output.deflate < 0) {
+            output.deflate = f;
+        } else {
+            return unsupported;
+        }
+    }
+
+    // Unallocated chunks would need to be filled, so we just give up.
+    if (H5Dget_num_chunks(dhandle.getId(), dspace.getId(), &(output.num_chunks)) < 0) {
+        return unsupported;
+    }
+    if (output.num_chunks != (output.length + output.chunk_length - 1) / output.chunk_length) {
+        return unsupported;
+    }
+
+    return output;
+}
+
+struct Workspace {
+    std::vector<unsigned char> inflated;
+    std::vector<unsigned char> unshuffled;
+};
+
+template<typename Input_, typename Output_>
+void convert(const unsigned char* src, size_t count, Output_* dest) {
+    for (size_t i = 0; i < count; ++i) {
+        Input_ val;
+        std::memcpy(&val, src + i * sizeof(Input_), sizeof(Input_));
+        dest[i] = val;
+    }
+}
+
+template<typename Output_>
+void decode(const Layout& layout, const std::vector<unsigned char>& raw, uint32_t mask, Workspace& work, hsize_t offset, Output_* output) {
+    size_t expected = layout.chunk_length * layout.type_size;
+    const unsigned char* data = raw.data();
+    size_t available = raw.size();
+
+    if (layout.deflate >= 0 && !(mask & (1u << layout.deflate))) {
+        work.inflated.resize(expected);
+        uLongf destlen = expected;
+        if (uncompress(work.inflated.data(), &destlen, data, available) != Z_OK || destlen != expected) {
+            throw std::runtime_error("failed to inflate the chunk at offset " + std::to_string(offset));
+        }
+        data = work.inflated.data();
+        available = destlen;
+    }
+
+    if (available != expected) {
+        throw std::runtime_error("unexpected number of bytes in the chunk at offset " + std::to_string(offset));
+    }
+
+    if (layout.shuffle >= 0 && !(mask & (1u << layout.shuffle)) && layout.type_size > 1) {
+        work.unshuffled.resize(expected);
+        size_t n = layout.chunk_length, size = layout.type_size;
+        for (size_t b = 0; b < size; ++b) {
+            const unsigned char* src = data + b * n;
+            for (size_t e = 0; e < n; ++e) {
+                work.unshuffled[e * size + b] = src[e];
+            }
+        }
+        data = work.unshuffled.data();
+    }
+
+    size_t count = std::min(layout.chunk_length, layout.length - offset);
+    Output_* dest = output + offset;
+    if (layout.kind == Kind::FLOAT) {
+        if (layout.type_size == 4) {
+            convert<float>(data, count, dest);
+        } else {
+            convert<double>(data, count, dest);
+        }
+    } else if (layout.kind == Kind::SIGNED) {
+        if (layout.type_size == 1) {
+            convert<int8_t>(data, count, dest);
+        } else if (layout.type_size == 2) {
+            convert<int16_t>(data, count, dest);
+        } else {
+            convert<int32_t>(data, count, dest);
+        }
+    } else {
+        if (layout.type_size == 1) {
+            convert<uint8_t>(data, count, dest);
+        } else if (layout.type_size == 2) {
+            convert<uint16_t>(data, count, dest);
+        } else {
+            convert<uint32_t>(data, count, dest);
+        }
+    }
+}
+
+// A single dataset to be read by read_all(). 'output' should have space for
+// 'layout->length' values, and should point to doubles if
+// 'layout->as_double()' is true, otherwise ints. If 'finish' is set, it is
+// called by the worker thread on the range of 'output' that was filled by
+// each chunk, e.g., to replace missing placeholders.
+struct Task {
+    const H5::DataSet* dhandle;
+    const Layout* layout;
+    void* output;
+    std::function<void(hsize_t, hsize_t)> finish;
+};
+
+inline void decode_task(const Task& task, const std::vector<unsigned char>& raw, uint32_t mask, Workspace& work, hsize_t offset) {
+    const auto& layout = *(task.layout);
+    if (layout.as_double()) {
+        decode(layout, raw, mask, work, offset, static_cast<double*>(task.output));
+    } else {
+        decode(layout, raw, mask, work, offset, static_cast<int*>(task.output));
+    }
+    if (task.finish) {
+        task.finish(offset, std::min(layout.chunk_length, layout.length - offset));
+    }
+}
+
+// Chunks of all datasets are fetched in order on the calling thread and then
+// decoded by a shared pool, so multiple datasets are decoded concurrently.
+inline void read_all(const std::vector<Task>& tasks, int num_threads) {
+    num_threads = std::max(num_threads, 1);
+    struct Job {
+        size_t task;
+        hsize_t offset;
+        uint32_t mask;
+        std::vector<unsigned char> raw;
+    };
+
+    std::deque<Job> queue;
+    std::mutex mut;
+    std::condition_variable cv;
+    bool finished = false;
+    std::string error;
+
+    // Limiting the number of fetched chunks that are waiting to be decoded.
+    size_t max_queued = 2 * static_cast<size_t>(num_threads);
+
+    std::vector<std::thread> workers;
+    workers.reserve(num_threads);
+    for (int t = 0; t < num_threads; ++t) {
+        workers.emplace_back([&]() -> void {
+            Workspace work;
+            while (true) {
+                Job job;
+                {
+                    std::unique_lock<std::mutex> lock(mut);
+                    cv.wait(lock, [&]() -> bool { return !queue.empty() || finished || !error.empty(); });
+                    if (!error.empty() || queue.empty()) {
+                        return;
+                    }
+                    job = std::move(queue.front());
+                    queue.pop_front();
+                }
+                cv.notify_all();
+
+                try {
+                    decode_task(tasks[job.task], job.raw, job.mask, work, job.offset);
+                } catch (std::exception& e) {
+                    std::lock_guard<std::mutex> lock(mut);
+                    if (error.empty()) {
+                        error = e.what();
+                    }
+                    cv.notify_all();
+                    return;
+                }
+            }
+        });
+    }
+
+    auto shutdown = [&]() -> void {
+        {
+            std::lock_guard<std::mutex> lock(mut);
+            finished = true;
+        }
+        cv.notify_all();
+        for (auto& w : workers) {
+            w.join();
+        }
+    };
+
+    bool failed = false;
+    try {
+        for (size_t i = 0, ntasks = tasks.size(); i < ntasks && !failed; ++i) {
+            const auto& task = tasks[i];
+            for (hsize_t c = 0; c < task.layout->num_chunks; ++c) {
+                Job job;
+                job.task = i;
+                job.offset = c * task.layout->chunk_length;
+
+                hsize_t nbytes = 0;
+                if (H5Dget_chunk_storage_size(task.dhandle->getId(), &(job.offset), &nbytes) < 0) {
+                    throw std::runtime_error("failed to get the size of the chunk at offset " + std::to_string(job.offset));
+                }
+                job.raw.resize(nbytes);
+                if (H5Dread_chunk(task.dhandle->getId(), H5P_DEFAULT, &(job.offset), &(job.mask), job.raw.data()) < 0) {
+                    throw std::runtime_error("failed to read the chunk at offset " + std::to_string(job.offset));
+                }
+
+                std::unique_lock<std::mutex> lock(mut);
+                cv.wait(lock, [&]() -> bool { return queue.size() < max_queued || !error.empty(); });
+                if (!error.empty()) {
+                    failed = true;
+                    break;
+                }
+                queue.push_back(std::move(job));
+                lock.unlock();
+                cv.notify_all();
+            }
+        }
+    } catch (...) {
+        shutdown();
+        throw;
+    }
+
+    shutdown();
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+}
+
+// 'output' should have space for 'layout.length' values, and should be of
+// type double if 'layout.as_double()' is true, otherwise int.
+template<typename Output_>
+void read(const H5::DataSet& dhandle, const Layout& layout, Output_* output, int num_threads) {
+    std::vector<Task> tasks(1);
+    tasks[0].dhandle = &dhandle;
+    tasks[0].layout = &layout;
+    tasks[0].output = output;
+    read_all(tasks, num_threads);
+}
+
+}
+
+#endif
@@ -0,0 +1,407 @@
+#ifndef PREFETCH_FILE_READER_H
+#define PREFETCH_FILE_READER_H
+
+#include "byteme/GzipFileReader.hpp"
+#include "zlib.h"
+
+#ifdef ALABASTER_HAS_ZSTD
+#include "zstd.h"
+#endif
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+/**
+ * Readers that keep several large reads in flight, so that parsing is not
+ * stalled by each blocking read on fast storage. Blocks are fetched with
+ * pread() by a small pool of threads into a ring of buffers, which are then
+ * handed to the parser in order. For compressed files, the prefetched bytes
+ * are decompressed on the parsing thread.
+ *
+ * Zstandard support is only available if the package was compiled with
+ * ALABASTER_HAS_ZSTD, see the Makevars.
+ */
+
+#ifndef _WIN32
+
+class PrefetchFileReader : public byteme::Reader {
+public:
+    PrefetchFileReader(const std::string& path, size_t block_size = 1048576, size_t num_inflight = 4) :
+        block_size(block_size > 0 ? block_size : 1),
+        slots(num_inflight > 0 ? num_inflight : 1)
+    {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("failed to open file at '" + path + "'");
+        }
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("failed to inspect file at '" + path + "'");
+        }
+        file_size = info.st_size;
+        num_blocks = (file_size + this->block_size - 1) / this->block_size;
+
+        for (auto& s : slots) {
+            s.buffer.resize(this->block_size);
+        }
+
+        size_t num_workers = std::min(slots.size(), num_blocks);
+        workers.reserve(num_workers);
+        for (size_t w = 0; w < num_workers; ++w) {
+            workers.emplace_back([this]() -> void { fetch(); });
+        }
+    }
+
+    ~PrefetchFileReader() {
+        {
+            std::lock_guard<std::mutex> lock(mut);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& w : workers) {
+            w.join();
+        }
+        ::close(fd);
+    }
+
+public:
+    bool load() {
+        if (consumed > 0) {
+            {
+                std::lock_guard<std::mutex> lock(mut);
+                slots[(consumed - 1) % slots.size()].state = EMPTY;
+            }
+            cv.notify_all();
+        }
+
+        if (consumed >= num_blocks) {
+            current = NULL;
+            len = 0;
+            return false;
+        }
+
+        auto& slot = slots[consumed % slots.size()];
+        {
+            std::unique_lock<std::mutex> lock(mut);
+            cv.wait(lock, [&]() -> bool { return slot.state == READY; });
+        }
+        if (!slot.error.empty()) {
+            throw std::runtime_error(slot.error);
+        }
+
+        current = slot.buffer.data();
+        len = slot.size;
+        ++consumed;
+        return consumed < num_blocks;
+    }
+
+    const unsigned char* buffer() const {
+        return current;
+    }
+
+    size_t available() const {
+        return len;
+    }
+
+private:
+    enum State { EMPTY, LOADING, READY };
+
+    struct Slot {
+        std::vector<unsigned char> buffer;
+        size_t size = 0;
+        State state = EMPTY;
+        std::string error;
+    };
+
+    int fd;
+    size_t file_size, block_size, num_blocks;
+    std::vector<Slot> slots;
+
+    std::vector<std::thread> workers;
+    std::mutex mut;
+    std::condition_variable cv;
+    size_t next_block = 0;
+    bool stopping = false;
+
+    size_t consumed = 0;
+    const unsigned char* current = NULL;
+    size_t len = 0;
+
+    void fetch() {
+        while (true) {
+            size_t b;
+            Slot* slot;
+            {
+                std::unique_lock<std::mutex> lock(mut);
+
+                // The slot for the next block is only free once the parser
+                // has released the block that was 'slots.size()' blocks ago.
+                cv.wait(lock, [&]() -> bool {
+                    return stopping || next_block >= num_blocks || slots[next_block % slots.size()].state == EMPTY;
+                });
+                if (stopping || next_block >= num_blocks) {
+                    return;
+                }
+
+                b = next_block;
+                ++next_block;
+                slot = &(slots[b % slots.size()]);
+                slot->state = LOADING;
+            }
+
+            size_t offset = b * block_size;
+            size_t expected = std::min(block_size, file_size - offset);
+            size_t filled = 0;
+            std::string error;
+
+            while (filled < expected) {
+                auto out = ::pread(fd, slot->buffer.data() + filled, expected - filled, offset + filled);
+                if (out < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    error = "failed to read file; " + std::string(std::strerror(errno));
+                    break;
+                } else if (out == 0) {
+                    error = "file was truncated during reading";
+                    break;
+                }
+                filled += out;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mut);
+                slot->size = filled;
+                slot->error = std::move(error);
+                slot->state = READY;
+            }
+            cv.notify_all();
+        }
+    }
+};
+
+#endif
+
+// Decompresses a Gzip stream from another reader. Concatenated members are
+// handled in the same manner as gzread().
+class InflateReader : public byteme::Reader {
+public:
+    InflateReader(byteme::Reader& source, size_t buffer_size = 1048576) : source(source), output(buffer_size > 0 ? buffer_size : 1) {
+        strm.zalloc = Z_NULL;
+        strm.zfree = Z_NULL;
+        strm.opaque = Z_NULL;
+        strm.avail_in = 0;
+        strm.next_in = Z_NULL;
+        if (inflateInit2(&strm, 16 + MAX_WBITS) != Z_OK) {
+            throw std::runtime_error("failed to initialize the Gzip decompressor");
+        }
+    }
+
+    ~InflateReader() {
+        inflateEnd(&strm);
+    }
+
+public:
+    bool load() {
+        if (finished) {
+            len = 0;
+            return false;
+        }
+
+        strm.next_out = output.data();
+        strm.avail_out = output.size();
+
+        while (strm.avail_out > 0) {
+            if (strm.avail_in == 0) {
+                if (!source_remaining) {
+                    break;
+                }
+                source_remaining = source.load();
+                strm.next_in = const_cast<unsigned char*>(source.buffer());
+                strm.avail_in = source.available();
+                if (strm.avail_in == 0) {
+                    continue;
+                }
+            }
+
+            int ret = inflate(&strm, Z_NO_FLUSH);
+            if (ret == Z_STREAM_END) {
+                if (strm.avail_in == 0 && source_remaining) {
+                    source_remaining = source.load();
+                    strm.next_in = const_cast<unsigned char*>(source.buffer());
+                    strm.avail_in = source.available();
+                }
+
+                // Trailing bytes that do not start another member are ignored, as in gzread().
+                if (strm.avail_in == 0 || strm.next_in[0] != 0x1f) {
+                    finished = true;
+                    break;
+                }
+                inflateReset(&strm);
+            } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                throw std::runtime_error("failed to decompress Gzip stream" + (strm.msg ? "; " + std::string(strm.msg) : std::string("")));
+            }
+        }
+
+        len = output.size() - strm.avail_out;
+        if (strm.avail_out > 0 && !finished) {
+            throw std::runtime_error("truncated Gzip stream");
+        }
+        return !finished;
+    }
+
+    const unsigned char* buffer() const {
+        return output.data();
+    }
+
+    size_t available() const {
+        return len;
+    }
+
+private:
+    byteme::Reader& source;
+    z_stream strm;
+    std::vector<unsigned char> output;
+    size_t len = 0;
+    bool source_remaining = true;
+    bool finished = false;
+};
+
+#ifdef ALABASTER_HAS_ZSTD
+
+// Decompresses a Zstandard stream from another reader, possibly containing
+// multiple concatenated frames.
+class ZstdReader : public byteme::Reader {
+public:
+    ZstdReader(byteme::Reader& source) : source(source), output(ZSTD_DStreamOutSize()) {
+        dctx = ZSTD_createDCtx();
+        if (dctx == NULL) {
+            throw std::runtime_error("failed to initialize the Zstandard decompressor");
+        }
+    }
+
+    ~ZstdReader() {
+        ZSTD_freeDCtx(dctx);
+    }
+
+public:
+    bool load() {
+        if (finished) {
+            len = 0;
+            return false;
+        }
+
+        ZSTD_outBuffer out = { output.data(), output.size(), 0 };
+        while (out.pos < out.size) {
+            if (in.pos == in.size) {
+                if (source_remaining) {
+                    source_remaining = source.load();
+                    in.src = source.buffer();
+                    in.size = source.available();
+                    in.pos = 0;
+                    continue;
+                }
+                if (last_ret == 0) { // i.e., the last frame is complete and fully flushed.
+                    finished = true;
+                    break;
+                }
+            }
+
+            size_t before = out.pos;
+            last_ret = ZSTD_decompressStream(dctx, &out, &in);
+            if (ZSTD_isError(last_ret)) {
+                throw std::runtime_error("failed to decompress Zstandard stream; " + std::string(ZSTD_getErrorName(last_ret)));
+            }
+            if (in.pos == in.size && !source_remaining && out.pos == before && last_ret != 0) {
+                throw std::runtime_error("truncated Zstandard stream");
+            }
+        }
+
+        len = out.pos;
+        return !finished;
+    }
+
+    const unsigned char* buffer() const {
+        return output.data();
+    }
+
+    size_t available() const {
+        return len;
+    }
+
+private:
+    byteme::Reader& source;
+    ZSTD_DCtx* dctx;
+    ZSTD_inBuffer in = { NULL, 0, 0 };
+    std::vector<unsigned char> output;
+    size_t len = 0;
+    size_t last_ret = 0;
+    bool source_remaining = true;
+    bool finished = false;
+};
+
+#endif
+
+enum class FileCompression { NONE, GZIP, ZSTD };
+
+inline FileCompression detect_compression(const std::string& path) {
+    unsigned char magic[4] = { 0, 0, 0, 0 };
+    std::ifstream handle(path, std::ios::binary);
+    if (!handle) {
+        throw std::runtime_error("failed to open file at '" + path + "'");
+    }
+    handle.read(reinterpret_cast<char*>(magic), 4);
+
+    if (magic[0] == 0x1f && magic[1] == 0x8b) {
+        return FileCompression::GZIP;
+    } else if (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+        return FileCompression::ZSTD;
+    }
+    return FileCompression::NONE;
+}
+
+// Calls 'fun' with a reader for 'path', which is decompressed if
+// 'is_compressed = true'. Like gzread(), files without the Gzip magic number
+// are read as-is. Zstandard-compressed files are always detected from their
+// magic number. On Windows, we fall back to byteme's blocking readers.
+template<class Function>
+void with_prefetching_reader(const std::string& path, bool is_compressed, Function fun) {
+    auto detected = detect_compression(path);
+
+#ifndef _WIN32
+    PrefetchFileReader raw(path);
+#else
+    byteme::RawFileReader raw(path);
+#endif
+
+    if (detected == FileCompression::ZSTD) {
+#ifdef ALABASTER_HAS_ZSTD
+        ZstdReader reader(raw);
+        fun(reader);
+#else
+        throw std::runtime_error("'" + path + "' is Zstandard-compressed but this build does not support Zstandard");
+#endif
+    } else if (is_compressed && detected == FileCompression::GZIP) {
+        InflateReader reader(raw);
+        fun(reader);
+    } else {
+        fun(raw);
+    }
+}
+
+#endif
@@ -23,14 +23,15 @@ BEGIN_RCPP
 END_RCPP
 }
 // check_list_hdf5
-SEXP check_list_hdf5(std::string file, std::string name, int num_external);
-RcppExport SEXP _alabaster_base_check_list_hdf5(SEXP fileSEXP, SEXP nameSEXP, SEXP num_externalSEXP) {
+SEXP check_list_hdf5(std::string file, std::string name, int num_external, bool packed);
+RcppExport SEXP _alabaster_base_check_list_hdf5(SEXP fileSEXP, SEXP nameSEXP, SEXP num_externalSEXP, SEXP packedSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::traits::input_parameter< std::string >::type file(fileSEXP);
     Rcpp::traits::input_parameter< std::string >::type name(nameSEXP);
     Rcpp::traits::input_parameter< int >::type num_external(num_externalSEXP);
-    rcpp_result_gen = Rcpp::wrap(check_list_hdf5(file, name, num_external));
+    Rcpp::traits::input_parameter< bool >::type packed(packedSEXP);
+    rcpp_result_gen = Rcpp::wrap(check_list_hdf5(file, name, num_external, packed));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -76,6 +77,70 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// scan_integer_range
+Rcpp::NumericVector scan_integer_range(Rcpp::IntegerVector x);
+RcppExport SEXP _alabaster_base_scan_integer_range(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(scan_integer_range(x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// is_float32_exact
+bool is_float32_exact(Rcpp::NumericVector x, bool skip_na);
+RcppExport SEXP _alabaster_base_is_float32_exact(SEXP xSEXP, SEXP skip_naSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< bool >::type skip_na(skip_naSEXP);
+    rcpp_result_gen = Rcpp::wrap(is_float32_exact(x, skip_na));
+    return rcpp_result_gen;
+END_RCPP
+}
+// choose_float32_missing_placeholder
+double choose_float32_missing_placeholder(Rcpp::NumericVector x);
+RcppExport SEXP _alabaster_base_choose_float32_missing_placeholder(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(choose_float32_missing_placeholder(x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// has_zstd_support
+bool has_zstd_support();
+RcppExport SEXP _alabaster_base_has_zstd_support() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    rcpp_result_gen = Rcpp::wrap(has_zstd_support());
+    return rcpp_result_gen;
+END_RCPP
+}
+// compress_zstd
+SEXP compress_zstd(std::string input, std::string output, int level, int num_threads);
+RcppExport SEXP _alabaster_base_compress_zstd(SEXP inputSEXP, SEXP outputSEXP, SEXP levelSEXP, SEXP num_threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< std::string >::type input(inputSEXP);
+    Rcpp::traits::input_parameter< std::string >::type output(outputSEXP);
+    Rcpp::traits::input_parameter< int >::type level(levelSEXP);
+    Rcpp::traits::input_parameter< int >::type num_threads(num_threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(compress_zstd(input, output, level, num_threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// create_paged_hdf5_file
+SEXP create_paged_hdf5_file(std::string path, double page_size);
+RcppExport SEXP _alabaster_base_create_paged_hdf5_file(SEXP pathSEXP, SEXP page_sizeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< double >::type page_size(page_sizeSEXP);
+    rcpp_result_gen = Rcpp::wrap(create_paged_hdf5_file(path, page_size));
+    return rcpp_result_gen;
+END_RCPP
+}
 // not_rfc3339
 Rcpp::LogicalVector not_rfc3339(Rcpp::CharacterVector x);
 RcppExport SEXP _alabaster_base_not_rfc3339(SEXP xSEXP) {
@@ -87,27 +152,56 @@ BEGIN_RCPP
 END_RCPP
 }
 // load_csv
-Rcpp::List load_csv(std::string path, bool is_compressed, int nrecords, bool parallel);
-RcppExport SEXP _alabaster_base_load_csv(SEXP pathSEXP, SEXP is_compressedSEXP, SEXP nrecordsSEXP, SEXP parallelSEXP) {
+Rcpp::List load_csv(std::string path, bool is_compressed, int nrecords, bool parallel, Rcpp::LogicalVector narrow_integers);
+RcppExport SEXP _alabaster_base_load_csv(SEXP pathSEXP, SEXP is_compressedSEXP, SEXP nrecordsSEXP, SEXP parallelSEXP, SEXP narrow_integersSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
     Rcpp::traits::input_parameter< bool >::type is_compressed(is_compressedSEXP);
     Rcpp::traits::input_parameter< int >::type nrecords(nrecordsSEXP);
     Rcpp::traits::input_parameter< bool >::type parallel(parallelSEXP);
-    rcpp_result_gen = Rcpp::wrap(load_csv(path, is_compressed, nrecords, parallel));
+    Rcpp::traits::input_parameter< Rcpp::LogicalVector >::type narrow_integers(narrow_integersSEXP);
+    rcpp_result_gen = Rcpp::wrap(load_csv(path, is_compressed, nrecords, parallel, narrow_integers));
+    return rcpp_result_gen;
+END_RCPP
+}
+// load_csv_shards
+Rcpp::List load_csv_shards(Rcpp::CharacterVector paths, Rcpp::LogicalVector is_compressed, int num_threads, Rcpp::LogicalVector narrow_integers);
+RcppExport SEXP _alabaster_base_load_csv_shards(SEXP pathsSEXP, SEXP is_compressedSEXP, SEXP num_threadsSEXP, SEXP narrow_integersSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< Rcpp::CharacterVector >::type paths(pathsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::LogicalVector >::type is_compressed(is_compressedSEXP);
+    Rcpp::traits::input_parameter< int >::type num_threads(num_threadsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::LogicalVector >::type narrow_integers(narrow_integersSEXP);
+    rcpp_result_gen = Rcpp::wrap(load_csv_shards(paths, is_compressed, num_threads, narrow_integers));
+    return rcpp_result_gen;
+END_RCPP
+}
+// load_hdf5_data_frame
+Rcpp::List load_hdf5_data_frame(std::string path, std::string group, Rcpp::IntegerVector columns, Rcpp::CharacterVector types, bool has_row_names);
+RcppExport SEXP _alabaster_base_load_hdf5_data_frame(SEXP pathSEXP, SEXP groupSEXP, SEXP columnsSEXP, SEXP typesSEXP, SEXP has_row_namesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< std::string >::type group(groupSEXP);
+    Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type columns(columnsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::CharacterVector >::type types(typesSEXP);
+    Rcpp::traits::input_parameter< bool >::type has_row_names(has_row_namesSEXP);
+    rcpp_result_gen = Rcpp::wrap(load_hdf5_data_frame(path, group, columns, types, has_row_names));
     return rcpp_result_gen;
 END_RCPP
 }
 // load_list_hdf5
-Rcpp::RObject load_list_hdf5(std::string file, std::string name, Rcpp::List obj);
-RcppExport SEXP _alabaster_base_load_list_hdf5(SEXP fileSEXP, SEXP nameSEXP, SEXP objSEXP) {
+Rcpp::RObject load_list_hdf5(std::string file, std::string name, Rcpp::List obj, bool packed);
+RcppExport SEXP _alabaster_base_load_list_hdf5(SEXP fileSEXP, SEXP nameSEXP, SEXP objSEXP, SEXP packedSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::traits::input_parameter< std::string >::type file(fileSEXP);
     Rcpp::traits::input_parameter< std::string >::type name(nameSEXP);
     Rcpp::traits::input_parameter< Rcpp::List >::type obj(objSEXP);
-    rcpp_result_gen = Rcpp::wrap(load_list_hdf5(file, name, obj));
+    Rcpp::traits::input_parameter< bool >::type packed(packedSEXP);
+    rcpp_result_gen = Rcpp::wrap(load_list_hdf5(file, name, obj, packed));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -123,6 +217,96 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// peek_csv
+Rcpp::List peek_csv(std::string path, bool is_compressed, int nrecords);
+RcppExport SEXP _alabaster_base_peek_csv(SEXP pathSEXP, SEXP is_compressedSEXP, SEXP nrecordsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< bool >::type is_compressed(is_compressedSEXP);
+    Rcpp::traits::input_parameter< int >::type nrecords(nrecordsSEXP);
+    rcpp_result_gen = Rcpp::wrap(peek_csv(path, is_compressed, nrecords));
+    return rcpp_result_gen;
+END_RCPP
+}
+// peek_json_fields
+Rcpp::List peek_json_fields(Rcpp::CharacterVector paths, Rcpp::CharacterVector fields);
+RcppExport SEXP _alabaster_base_peek_json_fields(SEXP pathsSEXP, SEXP fieldsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< Rcpp::CharacterVector >::type paths(pathsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::CharacterVector >::type fields(fieldsSEXP);
+    rcpp_result_gen = Rcpp::wrap(peek_json_fields(paths, fields));
+    return rcpp_result_gen;
+END_RCPP
+}
+// peek_list_json
+Rcpp::List peek_list_json(std::string path);
+RcppExport SEXP _alabaster_base_peek_list_json(SEXP pathSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    rcpp_result_gen = Rcpp::wrap(peek_list_json(path));
+    return rcpp_result_gen;
+END_RCPP
+}
+// peek_list_hdf5
+Rcpp::List peek_list_hdf5(std::string path, std::string name);
+RcppExport SEXP _alabaster_base_peek_list_hdf5(SEXP pathSEXP, SEXP nameSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< std::string >::type name(nameSEXP);
+    rcpp_result_gen = Rcpp::wrap(peek_list_hdf5(path, name));
+    return rcpp_result_gen;
+END_RCPP
+}
+// read_hdf5_chunks_parallel
+SEXP read_hdf5_chunks_parallel(std::string path, std::string name, int num_threads);
+RcppExport SEXP _alabaster_base_read_hdf5_chunks_parallel(SEXP pathSEXP, SEXP nameSEXP, SEXP num_threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< std::string >::type name(nameSEXP);
+    Rcpp::traits::input_parameter< int >::type num_threads(num_threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(read_hdf5_chunks_parallel(path, name, num_threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// read_hdf5_columns_parallel
+Rcpp::List read_hdf5_columns_parallel(std::string path, Rcpp::CharacterVector names, Rcpp::List placeholders, int num_threads);
+RcppExport SEXP _alabaster_base_read_hdf5_columns_parallel(SEXP pathSEXP, SEXP namesSEXP, SEXP placeholdersSEXP, SEXP num_threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< Rcpp::CharacterVector >::type names(namesSEXP);
+    Rcpp::traits::input_parameter< Rcpp::List >::type placeholders(placeholdersSEXP);
+    Rcpp::traits::input_parameter< int >::type num_threads(num_threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(read_hdf5_columns_parallel(path, names, placeholders, num_threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// read_hdf5_mapped
+SEXP read_hdf5_mapped(std::string path, std::string name);
+RcppExport SEXP _alabaster_base_read_hdf5_mapped(SEXP pathSEXP, SEXP nameSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< std::string >::type name(nameSEXP);
+    rcpp_result_gen = Rcpp::wrap(read_hdf5_mapped(path, name));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sync_file
+SEXP sync_file(std::string path);
+RcppExport SEXP _alabaster_base_sync_file(SEXP pathSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    rcpp_result_gen = Rcpp::wrap(sync_file(path));
+    return rcpp_result_gen;
+END_RCPP
+}
 // validate
 Rcpp::RObject validate(std::string path, Rcpp::RObject metadata);
 RcppExport SEXP _alabaster_base_validate(SEXP pathSEXP, SEXP metadataSEXP) {
@@ -254,18 +438,44 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// register_packed_list
+Rcpp::RObject register_packed_list(bool set);
+RcppExport SEXP _alabaster_base_register_packed_list(SEXP setSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::traits::input_parameter< bool >::type set(setSEXP);
+    rcpp_result_gen = Rcpp::wrap(register_packed_list(set));
+    return rcpp_result_gen;
+END_RCPP
+}
 
 static const R_CallMethodDef CallEntries[] = {
     {"_alabaster_base_check_csv", (DL_FUNC) &_alabaster_base_check_csv, 3},
-    {"_alabaster_base_check_list_hdf5", (DL_FUNC) &_alabaster_base_check_list_hdf5, 3},
+    {"_alabaster_base_check_list_hdf5", (DL_FUNC) &_alabaster_base_check_list_hdf5, 4},
     {"_alabaster_base_check_list_json", (DL_FUNC) &_alabaster_base_check_list_json, 3},
     {"_alabaster_base_any_actually_numeric_na", (DL_FUNC) &_alabaster_base_any_actually_numeric_na, 1},
     {"_alabaster_base_is_actually_numeric_na", (DL_FUNC) &_alabaster_base_is_actually_numeric_na, 1},
     {"_alabaster_base_choose_numeric_missing_placeholder", (DL_FUNC) &_alabaster_base_choose_numeric_missing_placeholder, 1},
+    {"_alabaster_base_scan_integer_range", (DL_FUNC) &_alabaster_base_scan_integer_range, 1},
+    {"_alabaster_base_is_float32_exact", (DL_FUNC) &_alabaster_base_is_float32_exact, 2},
+    {"_alabaster_base_choose_float32_missing_placeholder", (DL_FUNC) &_alabaster_base_choose_float32_missing_placeholder, 1},
+    {"_alabaster_base_has_zstd_support", (DL_FUNC) &_alabaster_base_has_zstd_support, 0},
+    {"_alabaster_base_compress_zstd", (DL_FUNC) &_alabaster_base_compress_zstd, 4},
+    {"_alabaster_base_create_paged_hdf5_file", (DL_FUNC) &_alabaster_base_create_paged_hdf5_file, 2},
     {"_alabaster_base_not_rfc3339", (DL_FUNC) &_alabaster_base_not_rfc3339, 1},
-    {"_alabaster_base_load_csv", (DL_FUNC) &_alabaster_base_load_csv, 4},
-    {"_alabaster_base_load_list_hdf5", (DL_FUNC) &_alabaster_base_load_list_hdf5, 3},
+    {"_alabaster_base_load_csv", (DL_FUNC) &_alabaster_base_load_csv, 5},
+    {"_alabaster_base_load_csv_shards", (DL_FUNC) &_alabaster_base_load_csv_shards, 4},
+    {"_alabaster_base_load_hdf5_data_frame", (DL_FUNC) &_alabaster_base_load_hdf5_data_frame, 5},
+    {"_alabaster_base_load_list_hdf5", (DL_FUNC) &_alabaster_base_load_list_hdf5, 4},
     {"_alabaster_base_load_list_json", (DL_FUNC) &_alabaster_base_load_list_json, 3},
+    {"_alabaster_base_peek_csv", (DL_FUNC) &_alabaster_base_peek_csv, 3},
+    {"_alabaster_base_peek_json_fields", (DL_FUNC) &_alabaster_base_peek_json_fields, 2},
+    {"_alabaster_base_peek_list_json", (DL_FUNC) &_alabaster_base_peek_list_json, 1},
+    {"_alabaster_base_peek_list_hdf5", (DL_FUNC) &_alabaster_base_peek_list_hdf5, 2},
+    {"_alabaster_base_read_hdf5_chunks_parallel", (DL_FUNC) &_alabaster_base_read_hdf5_chunks_parallel, 3},
+    {"_alabaster_base_read_hdf5_columns_parallel", (DL_FUNC) &_alabaster_base_read_hdf5_columns_parallel, 4},
+    {"_alabaster_base_read_hdf5_mapped", (DL_FUNC) &_alabaster_base_read_hdf5_mapped, 2},
+    {"_alabaster_base_sync_file", (DL_FUNC) &_alabaster_base_sync_file, 1},
     {"_alabaster_base_validate", (DL_FUNC) &_alabaster_base_validate, 2},
     {"_alabaster_base_register_validate_function", (DL_FUNC) &_alabaster_base_register_validate_function, 3},
     {"_alabaster_base_deregister_validate_function", (DL_FUNC) &_alabaster_base_deregister_validate_function, 1},
@@ -278,10 +488,13 @@ static const R_CallMethodDef CallEntries[] = {
     {"_alabaster_base_deregister_satisfies_interface", (DL_FUNC) &_alabaster_base_deregister_satisfies_interface, 2},
     {"_alabaster_base_register_derived_from", (DL_FUNC) &_alabaster_base_register_derived_from, 2},
     {"_alabaster_base_deregister_derived_from", (DL_FUNC) &_alabaster_base_deregister_derived_from, 2},
+    {"_alabaster_base_register_packed_list", (DL_FUNC) &_alabaster_base_register_packed_list, 1},
     {NULL, NULL, 0}
 };
 
+void init_mapped_vectors(DllInfo* dll);
 RcppExport void R_init_alabaster_base(DllInfo *dll) {
     R_registerRoutines(dll, NULL, CallEntries, NULL, NULL);
     R_useDynamicSymbols(dll, FALSE);
+    init_mapped_vectors(dll);
 }
@@ -1,6 +1,7 @@
 #include "Rcpp.h"
 #include "comservatory/comservatory.hpp"
 #include "byteme/GzipFileReader.hpp"
+#include "PrefetchFileReader.h"
 
 //[[Rcpp::export(rng=false)]]
 Rcpp::RObject check_csv(std::string path, bool is_compressed, bool parallel) {
@@ -8,13 +9,9 @@ Rcpp::RObject check_csv(std::string path, bool is_compressed, bool parallel) {
     opts.parallel = parallel;
     opts.validate_only = true;
 
-    if (is_compressed) {
-        byteme::GzipFileReader reader(path);
+    with_prefetching_reader(path, is_compressed, [&](byteme::Reader& reader) -> void {
         comservatory::read(reader, opts);
-    } else {
-        byteme::RawFileReader reader(path);
-        comservatory::read(reader, opts);
-    }
+    });
 
     return R_NilValue;
 }
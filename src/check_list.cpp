@@ -1,17 +1,30 @@
 #include "Rcpp.h"
 
 #include "uzuki2/uzuki2.hpp"
+#include "PrefetchFileReader.h"
+#include "JsonListStreamer.h"
+#include "Hdf5ListParser.h"
+#include "PagedHdf5File.h"
 
 // [[Rcpp::export(rng=false)]]
-SEXP check_list_hdf5(std::string file, std::string name, int num_external) {
-    uzuki2::hdf5::validate(file, name, num_external);
+SEXP check_list_hdf5(std::string file, std::string name, int num_external, bool packed) {
+    auto handle = open_hdf5_file(file);
+
+    // Using the same iterative parser as load_list_hdf5(), so that validation
+    // does not depend on the nesting depth and agrees with loading.
+    JsonValidationExternals others(num_external);
+    Hdf5ListParser<JsonValidationProvisioner, JsonValidationExternals> parser(std::move(others), packed);
+    parser.parse(handle, name);
     return R_NilValue;
 }
 
 // [[Rcpp::export(rng=false)]]
 SEXP check_list_json(std::string file, int num_external, bool parallel) {
-    uzuki2::json::Options opt;
-    opt.parallel = parallel;
-    uzuki2::json::validate_file(file, num_external, opt);
+    // Using the same parser as load_list_json(), so that loading and
+    // validation always agree on which documents are acceptable.
+    with_prefetching_reader(file, true, [&](byteme::Reader& reader) -> void {
+        JsonListStreamer<JsonValidationProvisioner, JsonValidationExternals> streamer(reader, JsonValidationExternals(num_external), parallel);
+        streamer.parse();
+    });
     return R_NilValue;
 }
@@ -1,6 +1,10 @@
 #include "Rcpp.h"
 #include "ritsuko/ritsuko.hpp"
 
+#include <vector>
+#include <cmath>
+#include <limits>
+
 //[[Rcpp::export(rng=false)]]
 bool any_actually_numeric_na(Rcpp::NumericVector x) {
     for (auto y : x) {
@@ -45,3 +49,67 @@ double choose_numeric_missing_placeholder(Rcpp::NumericVector x) {
     }
     return p.second;
 }
+
+// Fused scan for the range of non-missing values and the presence of NAs, to
+// choose the narrowest integer type for saving. Returns (min, max, has_na);
+// the range is (0, 0) if there are no non-missing values.
+//[[Rcpp::export(rng=false)]]
+Rcpp::NumericVector scan_integer_range(Rcpp::IntegerVector x) {
+    bool has_na = false, found = false;
+    int lower = 0, upper = 0;
+    for (auto y : x) {
+        if (y == NA_INTEGER) {
+            has_na = true;
+        } else if (!found) {
+            lower = y;
+            upper = y;
+            found = true;
+        } else if (y < lower) {
+            lower = y;
+        } else if (y > upper) {
+            upper = y;
+        }
+    }
+    return Rcpp::NumericVector::create(lower, upper, has_na);
+}
+
+// Checks whether all values survive a round trip through single precision, so
+// that they can be saved as 32-bit floats without any loss. R's NA is a NaN
+// with a payload that is lost upon conversion, so we only permit NaNs if they
+// are all NAs or all non-NA NaNs, i.e., they don't need to be distinguished.
+// NAs can also be skipped if they will be replaced by a placeholder anyway.
+//[[Rcpp::export(rng=false)]]
+bool is_float32_exact(Rcpp::NumericVector x, bool skip_na) {
+    constexpr double limit = std::numeric_limits<float>::max();
+    bool has_na = false, has_nan = false;
+    for (auto y : x) {
+        if (std::isnan(y)) {
+            if (ISNA(y)) {
+                has_na = !skip_na;
+            } else {
+                has_nan = true;
+            }
+            if (has_na && has_nan) {
+                return false;
+            }
+        } else if (std::isfinite(y) && std::abs(y) > limit) {
+            return false;
+        } else if (static_cast<double>(static_cast<float>(y)) != y) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Same as choose_numeric_missing_placeholder(), but the placeholder is also
+// guaranteed to be exactly representable in single precision. This should
+// only be called if is_float32_exact() is true. Returns NA on failure.
+//[[Rcpp::export(rng=false)]]
+double choose_float32_missing_placeholder(Rcpp::NumericVector x) {
+    std::vector<float> copy(x.begin(), x.end());
+    auto p = ritsuko::choose_missing_float_placeholder(copy.begin(), copy.end(), /* skip_nan = */ true);
+    if (!p.first) {
+        return NA_REAL;
+    }
+    return p.second;
+}
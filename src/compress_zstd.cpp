@@ -0,0 +1,117 @@
+#include "Rcpp.h"
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <stdexcept>
+#include <filesystem>
+#include <system_error>
+
+#ifdef ALABASTER_HAS_ZSTD
+#include "zstd.h"
+#endif
+
+// [[Rcpp::export(rng=false)]]
+bool has_zstd_support() {
+#ifdef ALABASTER_HAS_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef ALABASTER_HAS_ZSTD
+static void compress_zstd_internal(const std::string& input, const std::string& output, int level, int num_threads) {
+    std::FILE* ihandle = std::fopen(input.c_str(), "rb");
+    if (ihandle == NULL) {
+        throw std::runtime_error("failed to open '" + input + "'");
+    }
+    std::FILE* ohandle = std::fopen(output.c_str(), "wb");
+    if (ohandle == NULL) {
+        std::fclose(ihandle);
+        throw std::runtime_error("failed to open '" + output + "'");
+    }
+
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    auto cleanup = [&]() -> void {
+        ZSTD_freeCCtx(cctx);
+        std::fclose(ihandle);
+        if (ohandle != NULL) {
+            std::fclose(ohandle);
+        }
+    };
+
+    try {
+        if (cctx == NULL) {
+            throw std::runtime_error("failed to initialize the Zstandard compressor");
+        }
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level);
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1);
+
+        // This fails if libzstd was built without multi-threading, in which
+        // case we just fall back to single-threaded compression.
+        if (num_threads > 1) {
+            ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, num_threads);
+        }
+
+        // Pledging the input size allows the compressor to tune its
+        // parameters for small files and records the size in the frame header.
+        std::error_code ec;
+        auto isize = std::filesystem::file_size(input, ec);
+        if (!ec) {
+            ZSTD_CCtx_setPledgedSrcSize(cctx, isize);
+        }
+
+        std::vector<char> ibuffer(ZSTD_CStreamInSize()), obuffer(ZSTD_CStreamOutSize());
+        while (true) {
+            size_t nread = std::fread(ibuffer.data(), 1, ibuffer.size(), ihandle);
+            if (std::ferror(ihandle)) {
+                throw std::runtime_error("failed to read from '" + input + "'");
+            }
+            bool last = (nread < ibuffer.size());
+            ZSTD_EndDirective mode = (last ? ZSTD_e_end : ZSTD_e_continue);
+            ZSTD_inBuffer in = { ibuffer.data(), nread, 0 };
+
+            bool done = false;
+            do {
+                ZSTD_outBuffer out = { obuffer.data(), obuffer.size(), 0 };
+                size_t remaining = ZSTD_compressStream2(cctx, &out, &in, mode);
+                if (ZSTD_isError(remaining)) {
+                    throw std::runtime_error("failed to compress '" + input + "'; " + std::string(ZSTD_getErrorName(remaining)));
+                }
+                if (std::fwrite(obuffer.data(), 1, out.pos, ohandle) != out.pos) {
+                    throw std::runtime_error("failed to write to '" + output + "'");
+                }
+                done = (last ? (remaining == 0) : (in.pos == in.size));
+            } while (!done);
+
+            if (last) {
+                break;
+            }
+        }
+
+        // Buffered writes may only fail when the file is flushed on close.
+        auto status = std::fclose(ohandle);
+        ohandle = NULL;
+        if (status != 0) {
+            throw std::runtime_error("failed to close '" + output + "'");
+        }
+
+    } catch (...) {
+        cleanup();
+        throw;
+    }
+
+    cleanup();
+}
+#else
+static void compress_zstd_internal(const std::string&, const std::string&, int, int) {
+    throw std::runtime_error("this build does not support Zstandard compression");
+}
+#endif
+
+// [[Rcpp::export(rng=false)]]
+SEXP compress_zstd(std::string input, std::string output, int level, int num_threads) {
+    compress_zstd_internal(input, output, level, num_threads);
+    return R_NilValue;
+}
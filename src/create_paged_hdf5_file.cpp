@@ -0,0 +1,20 @@
+#include "Rcpp.h"
+#include "PagedHdf5File.h"
+
+#include <string>
+#include <stdexcept>
+
+// Creating an empty file with the paged strategy, which is persisted in the
+// superblock and respected by anyone who subsequently writes to the file.
+// [[Rcpp::export(rng=false)]]
+SEXP create_paged_hdf5_file(std::string path, double page_size) {
+    H5::FileCreatPropList fcpl;
+    if (H5Pset_file_space_strategy(fcpl.getId(), H5F_FSPACE_STRATEGY_PAGE, /* persist = */ 0, /* threshold = */ 1) < 0) {
+        throw std::runtime_error("failed to set the paged file space strategy");
+    }
+    if (H5Pset_file_space_page_size(fcpl.getId(), static_cast<hsize_t>(page_size)) < 0) {
+        throw std::runtime_error("failed to set the file space page size to " + std::to_string(static_cast<hsize_t>(page_size)));
+    }
+    H5::H5File handle(path, H5F_ACC_TRUNC, fcpl);
+    return R_NilValue;
+}
@@ -1,6 +1,12 @@
 #include "Rcpp.h"
 #include "comservatory/comservatory.hpp"
 #include "byteme/GzipFileReader.hpp"
+#include "PrefetchFileReader.h"
+#include "CsvColumnStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 /** Defining the R fields. **/
 
@@ -13,6 +19,7 @@ struct RFilledField : public comservatory::TypedField<T, tt> {
         for(size_t i = 0; i < current; ++i) {
             set_NA(store, i);
         }
+        stats.num_missing = current;
         return;
     }
 
@@ -28,6 +35,7 @@ struct RFilledField : public comservatory::TypedField<T, tt> {
         if (position >= static_cast<size_t>(store.size())) {
             throw std::runtime_error("more records than specified in preallocation");
         }
+        stats.add(in);
         store[position] = in;
         ++position;
         return;
@@ -38,6 +46,7 @@ struct RFilledField : public comservatory::TypedField<T, tt> {
             throw std::runtime_error("more records than specified in preallocation");
         }
         set_NA(store, position);
+        ++stats.num_missing;
         ++position;
         return;
     }
@@ -46,6 +55,7 @@ struct RFilledField : public comservatory::TypedField<T, tt> {
 
     size_t position;
     RVector store;
+    ColumnStats stats;
 };
 
 typedef RFilledField<std::string, comservatory::STRING, Rcpp::CharacterVector> RFilledStringField;
@@ -82,6 +92,9 @@ void RFilledComplexField::set_NA(Rcpp::ComplexVector& store, size_t pos) {
 
 template<>
 void RFilledComplexField::push_back(std::complex<double> in) {
+    if (position >= static_cast<size_t>(store.size())) {
+        throw std::runtime_error("more records than specified in preallocation");
+    }
     Rcomplex val;
     val.i = in.imag();
     val.r = in.real();
@@ -90,6 +103,84 @@ void RFilledComplexField::push_back(std::complex<double> in) {
     return;
 }
 
+/** Defining a number field that is stored as integers where possible. **/
+
+// This stores values in an integer vector until we encounter a value that
+// cannot be exactly represented as a non-NA integer, at which point we migrate
+// everything to a double-precision vector. -2^31 is deliberately excluded as
+// it would otherwise be interpreted as R's NA.
+struct RNarrowingNumberField : public comservatory::NumberField {
+    RNarrowingNumberField(size_t current, size_t max) : position(current), capacity(max), integers(max) {
+        if (current > max) {
+            throw std::runtime_error("more records than specified in preallocation");
+        }
+        std::fill(integers.begin(), integers.begin() + current, NA_INTEGER);
+        stats.num_missing = current;
+        return;
+    }
+
+    size_t size() const { return position; }
+
+    ::SEXP SEXP() const { 
+        if (narrowed) {
+            return integers;
+        } else {
+            return doubles;
+        }
+    }
+
+    void push_back(double in) {
+        if (position >= capacity) {
+            throw std::runtime_error("more records than specified in preallocation");
+        }
+        stats.add(in);
+
+        if (narrowed) {
+            if (in > -2147483648.0 && in <= 2147483647.0 && in == std::trunc(in)) {
+                integers[position] = in;
+                ++position;
+                return;
+            }
+            migrate();
+        }
+
+        doubles[position] = in;
+        ++position;
+        return;
+    }
+
+    void add_missing() {
+        if (position >= capacity) {
+            throw std::runtime_error("more records than specified in preallocation");
+        }
+        if (narrowed) {
+            integers[position] = NA_INTEGER;
+        } else {
+            doubles[position] = NA_REAL;
+        }
+        ++stats.num_missing;
+        ++position;
+        return;
+    }
+
+    void migrate() {
+        doubles = Rcpp::NumericVector(capacity);
+        for (size_t i = 0; i < position; ++i) {
+            auto val = integers[i];
+            doubles[i] = (val == NA_INTEGER ? NA_REAL : static_cast<double>(val));
+        }
+        integers = Rcpp::IntegerVector(0);
+        narrowed = false;
+        return;
+    }
+
+    size_t position, capacity;
+    bool narrowed = true;
+    Rcpp::IntegerVector integers;
+    Rcpp::NumericVector doubles;
+    ColumnStats stats;
+};
+
 /** Defining the creator. **/
 
 struct RFieldCreator : public comservatory::FieldCreator {
@@ -125,42 +216,76 @@ private:
 /** Defining the actual interface code. **/
 
 // [[Rcpp::export(rng=false)]]
-Rcpp::List load_csv(std::string path, bool is_compressed, int nrecords, bool parallel) {
+Rcpp::List load_csv(std::string path, bool is_compressed, int nrecords, bool parallel, Rcpp::LogicalVector narrow_integers) {
     RFieldCreator creator(nrecords);
     comservatory::ReadOptions opt;
     opt.creator = &creator;
     opt.parallel = parallel;
 
+    // Columns to be narrowed are expected to contain numbers, so we pre-fill
+    // them with narrowing fields; the parser will complain if they contain
+    // anything else. All other columns are left for the creator to resolve.
     comservatory::Contents output;
-    if (is_compressed) {
-        byteme::GzipFileReader reader(path);
-        output = comservatory::read(reader, opt);
-    } else {
-        byteme::RawFileReader reader(path);
-        output = comservatory::read(reader, opt);
+    size_t nnarrow = narrow_integers.size();
+    bool any_narrow = std::any_of(narrow_integers.begin(), narrow_integers.end(), [](int x) -> bool { return x == 1; });
+    if (any_narrow) {
+        output.fields.resize(nnarrow);
+        for (size_t c = 0; c < nnarrow; ++c) {
+            if (narrow_integers[c] == 1) {
+                output.fields[c].reset(new RNarrowingNumberField(0, nrecords));
+            } else {
+                output.fields[c].reset(new comservatory::UnknownField);
+            }
+        }
     }
 
+    with_prefetching_reader(path, is_compressed, [&](byteme::Reader& reader) -> void {
+        comservatory::read(reader, output, opt);
+    });
+
     Rcpp::List listed(output.num_fields());
+    StatsCollector collected(output.num_fields());
+
     for (size_t o = 0; o < output.num_fields(); ++o) {
         if (output.fields[o]->filled()) {
             switch (output.fields[o]->type()) {
                 case comservatory::STRING:
-                    listed[o] = static_cast<RFilledStringField*>(output.fields[o].get())->SEXP();
+                    {
+                        auto ptr = static_cast<RFilledStringField*>(output.fields[o].get());
+                        listed[o] = ptr->SEXP();
+                        collected.set(o, ptr->stats, comservatory::STRING);
+                    }
                     break;
                 case comservatory::NUMBER:
-                    listed[o] = static_cast<RFilledNumberField*>(output.fields[o].get())->SEXP();
+                    if (auto nptr = dynamic_cast<RNarrowingNumberField*>(output.fields[o].get())) {
+                        listed[o] = nptr->SEXP();
+                        collected.set(o, nptr->stats, comservatory::NUMBER);
+                    } else {
+                        auto ptr = static_cast<RFilledNumberField*>(output.fields[o].get());
+                        listed[o] = ptr->SEXP();
+                        collected.set(o, ptr->stats, comservatory::NUMBER);
+                    }
                     break;
                 case comservatory::BOOLEAN:
-                    listed[o] = static_cast<RFilledBooleanField*>(output.fields[o].get())->SEXP();
+                    {
+                        auto ptr = static_cast<RFilledBooleanField*>(output.fields[o].get());
+                        listed[o] = ptr->SEXP();
+                        collected.set(o, ptr->stats, comservatory::BOOLEAN);
+                    }
                     break;
                 case comservatory::COMPLEX:
-                    listed[o] = static_cast<RFilledComplexField*>(output.fields[o].get())->SEXP();
+                    {
+                        auto ptr = static_cast<RFilledComplexField*>(output.fields[o].get());
+                        listed[o] = ptr->SEXP();
+                        collected.set(o, ptr->stats, comservatory::COMPLEX);
+                    }
                     break;
                 case comservatory::UNKNOWN:
                     {
                         Rcpp::LogicalVector tmp(output.fields[o]->size());
                         std::fill(tmp.begin(), tmp.end(), NA_LOGICAL);
                         listed[o] = tmp;
+                        collected.set_missing(o, tmp.size());
                     }
                     break;
                 default:
@@ -173,6 +298,7 @@ Rcpp::List load_csv(std::string path, bool is_compressed, int nrecords, bool par
     if (listed.size() == 0) {
         listed.attr("num.records") = output.num_records();
     }
+    listed.attr("column.stats") = collected.yield();
 
     return listed;
 }
@@ -0,0 +1,507 @@
+#include "Rcpp.h"
+#include "comservatory/comservatory.hpp"
+#include "byteme/GzipFileReader.hpp"
+#include "PrefetchFileReader.h"
+#include "CsvColumnStats.h"
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <complex>
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * Loading multiple CSV shards with identical headers into a single set of
+ * columns. Each shard is parsed concurrently into plain C++ buffers that use
+ * R's representation of each type, after which the column types are reconciled
+ * across shards and each shard is copied into its offset range of the
+ * preallocated R vectors. This avoids the repeated copies from an R-level
+ * rbind() of the per-shard data frames. Column statistics and integer
+ * narrowing are computed on the combined columns to match load_csv().
+ */
+
+namespace {
+
+/** Defining the buffered fields. **/
+
+template<typename T, comservatory::Type tt, typename Stored>
+struct BufferedField : public comservatory::TypedField<T, tt> {
+    BufferedField(size_t n) : values(n, na()) {}
+
+    comservatory::Type type() const { return tt; }
+
+    size_t size() const { return values.size(); }
+
+    void push_back(T in) {
+        values.push_back(convert(in));
+    }
+
+    void add_missing() {
+        values.push_back(na());
+    }
+
+    static Stored na();
+
+    static Stored convert(T in);
+
+    std::vector<Stored> values;
+};
+
+typedef BufferedField<double, comservatory::NUMBER, double> BufferedNumberField;
+typedef BufferedField<bool, comservatory::BOOLEAN, int> BufferedBooleanField;
+typedef BufferedField<std::complex<double>, comservatory::COMPLEX, Rcomplex> BufferedComplexField;
+
+template<>
+double BufferedNumberField::na() { return NA_REAL; }
+
+template<>
+double BufferedNumberField::convert(double in) { return in; }
+
+template<>
+int BufferedBooleanField::na() { return NA_LOGICAL; }
+
+template<>
+int BufferedBooleanField::convert(bool in) { return in; }
+
+template<>
+Rcomplex BufferedComplexField::na() {
+    Rcomplex val;
+    val.r = NA_REAL;
+    val.i = NA_REAL;
+    return val;
+}
+
+template<>
+Rcomplex BufferedComplexField::convert(std::complex<double> in) {
+    Rcomplex val;
+    val.r = in.real();
+    val.i = in.imag();
+    return val;
+}
+
+// Strings can't be created outside of the main thread, so we just hold onto
+// them and remember which ones were missing.
+struct BufferedStringField : public comservatory::TypedField<std::string, comservatory::STRING> {
+    BufferedStringField(size_t n) : values(n), missing(n, 1) {}
+
+    comservatory::Type type() const { return comservatory::STRING; }
+
+    size_t size() const { return values.size(); }
+
+    void push_back(std::string in) {
+        values.push_back(std::move(in));
+        missing.push_back(0);
+    }
+
+    void add_missing() {
+        values.emplace_back();
+        missing.push_back(1);
+    }
+
+    std::vector<std::string> values;
+    std::vector<unsigned char> missing;
+};
+
+struct BufferedFieldCreator : public comservatory::FieldCreator {
+    comservatory::Field* create(comservatory::Type observed, size_t n, bool) const {
+        switch (observed) {
+            case comservatory::STRING:
+                return new BufferedStringField(n);
+            case comservatory::NUMBER:
+                return new BufferedNumberField(n);
+            case comservatory::BOOLEAN:
+                return new BufferedBooleanField(n);
+            case comservatory::COMPLEX:
+                return new BufferedComplexField(n);
+            default:
+                break;
+        }
+        throw std::runtime_error("unrecognized type during field creation");
+    }
+};
+
+/** Reading only the header of the first shard. **/
+
+class HeaderOnlyReader : public byteme::Reader {
+public:
+    HeaderOnlyReader(byteme::Reader& r) : inner(r) {}
+
+    bool load() {
+        if (finished) {
+            len = 0;
+            return false;
+        }
+
+        bool remaining = inner.load();
+        ptr = inner.buffer();
+        len = inner.available();
+
+        // Header names are always quoted, so we can find the end of the header
+        // by looking for the first newline outside of a quoted string. Escaped
+        // quotes ("") toggle the state twice and are correctly ignored.
+        for (size_t i = 0; i < len; ++i) {
+            char c = ptr[i];
+            if (c == '"') {
+                in_quote = !in_quote;
+            } else if (c == '\n' && !in_quote) {
+                len = i + 1;
+                finished = true;
+                return false;
+            }
+        }
+
+        if (!remaining) {
+            finished = true;
+        }
+        return remaining;
+    }
+
+    const unsigned char* buffer() const { return ptr; }
+
+    size_t available() const { return len; }
+
+private:
+    byteme::Reader& inner;
+    const unsigned char* ptr = nullptr;
+    size_t len = 0;
+    bool in_quote = false;
+    bool finished = false;
+};
+
+template<class Function>
+void with_reader(const std::string& path, bool is_compressed, Function fun) {
+    with_prefetching_reader(path, is_compressed, fun);
+}
+
+std::vector<std::string> read_header(const std::string& path, bool is_compressed) {
+    comservatory::Contents contents;
+    comservatory::ReadOptions opt;
+    opt.validate_only = true;
+
+    with_reader(path, is_compressed, [&](byteme::Reader& reader) -> void {
+        HeaderOnlyReader hreader(reader);
+        comservatory::read(hreader, contents, opt);
+    });
+
+    return contents.names;
+}
+
+/** Reconciling types across shards. **/
+
+comservatory::Type reconcile(comservatory::Type left, comservatory::Type right, const std::string& name) {
+    if (left == comservatory::UNKNOWN) {
+        return right;
+    } else if (right == comservatory::UNKNOWN || left == right) {
+        return left;
+    }
+
+    if (left == comservatory::STRING || right == comservatory::STRING) {
+        throw std::runtime_error("inconsistent types for column '" + name + "' across shards");
+    }
+
+    // Otherwise, promoting along BOOLEAN -> NUMBER -> COMPLEX, as done by rbind().
+    if (left == comservatory::COMPLEX || right == comservatory::COMPLEX) {
+        return comservatory::COMPLEX;
+    }
+    return comservatory::NUMBER;
+}
+
+template<class Output>
+void copy_shard(const comservatory::Field* field, Output* out) {
+    switch (field->type()) {
+        case comservatory::NUMBER:
+            {
+                const auto& values = static_cast<const BufferedNumberField*>(field)->values;
+                if constexpr(std::is_same<Output, double>::value) {
+                    std::copy(values.begin(), values.end(), out);
+                } else if constexpr(std::is_same<Output, Rcomplex>::value) {
+                    for (auto x : values) {
+                        out->r = x;
+                        out->i = (ISNA(x) ? NA_REAL : 0);
+                        ++out;
+                    }
+                }
+            }
+            break;
+        case comservatory::BOOLEAN:
+            {
+                const auto& values = static_cast<const BufferedBooleanField*>(field)->values;
+                if constexpr(std::is_same<Output, int>::value) {
+                    std::copy(values.begin(), values.end(), out);
+                } else if constexpr(std::is_same<Output, double>::value) {
+                    for (auto x : values) {
+                        *out = (x == NA_LOGICAL ? NA_REAL : static_cast<double>(x));
+                        ++out;
+                    }
+                } else if constexpr(std::is_same<Output, Rcomplex>::value) {
+                    for (auto x : values) {
+                        out->r = (x == NA_LOGICAL ? NA_REAL : static_cast<double>(x));
+                        out->i = (x == NA_LOGICAL ? NA_REAL : 0);
+                        ++out;
+                    }
+                }
+            }
+            break;
+        case comservatory::COMPLEX:
+            {
+                if constexpr(std::is_same<Output, Rcomplex>::value) {
+                    const auto& values = static_cast<const BufferedComplexField*>(field)->values;
+                    std::copy(values.begin(), values.end(), out);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/** Computing statistics for each shard's range of the combined column. **/
+
+template<typename Value>
+ColumnStats compute_stats(const Value* ptr, size_t n) {
+    ColumnStats stats;
+    for (size_t i = 0; i < n; ++i) {
+        auto x = ptr[i];
+        if constexpr(std::is_same<Value, double>::value) {
+            if (ISNA(x)) {
+                ++stats.num_missing;
+            } else {
+                stats.add(x);
+            }
+        } else if constexpr(std::is_same<Value, int>::value) {
+            if (x == NA_LOGICAL) {
+                ++stats.num_missing;
+            } else {
+                stats.add(static_cast<bool>(x));
+            }
+        } else {
+            if (ISNA(x.r)) {
+                ++stats.num_missing;
+            }
+        }
+    }
+    return stats;
+}
+
+// Mimicking RNarrowingNumberField in load_csv.cpp, where -2^31 is excluded as
+// it would otherwise be interpreted as R's NA.
+bool can_narrow(const ColumnStats& stats) {
+    if (!stats.integral || stats.num_nan) {
+        return false;
+    }
+    if (stats.min > stats.max) { // all missing.
+        return true;
+    }
+    return stats.min > -2147483648.0 && stats.max <= 2147483647.0;
+}
+
+template<typename Task>
+void run_parallel(size_t njobs, int nthreads, Task task) {
+    if (nthreads <= 1 || njobs <= 1) {
+        for (size_t j = 0; j < njobs; ++j) {
+            task(j);
+        }
+        return;
+    }
+
+    size_t nworkers = std::min(static_cast<size_t>(nthreads), njobs);
+    std::vector<std::string> errors(nworkers);
+    std::vector<std::thread> workers;
+    workers.reserve(nworkers);
+
+    for (size_t w = 0; w < nworkers; ++w) {
+        workers.emplace_back([&](size_t id) -> void {
+            try {
+                for (size_t j = id; j < njobs; j += nworkers) {
+                    task(j);
+                }
+            } catch (std::exception& e) {
+                errors[id] = e.what();
+            } catch (...) {
+                errors[id] = "unknown error in worker thread";
+            }
+        }, w);
+    }
+
+    for (auto& w : workers) {
+        w.join();
+    }
+    for (const auto& e : errors) {
+        if (!e.empty()) {
+            throw std::runtime_error(e);
+        }
+    }
+}
+
+}
+
+// [[Rcpp::export(rng=false)]]
+Rcpp::List load_csv_shards(Rcpp::CharacterVector paths, Rcpp::LogicalVector is_compressed, int num_threads, Rcpp::LogicalVector narrow_integers) {
+    size_t nshards = paths.size();
+    if (nshards == 0) {
+        throw std::runtime_error("expected at least one path");
+    }
+    if (static_cast<size_t>(is_compressed.size()) != nshards) {
+        throw std::runtime_error("'is_compressed' should have the same length as 'paths'");
+    }
+
+    std::vector<std::string> all_paths;
+    std::vector<unsigned char> all_compressed;
+    for (size_t s = 0; s < nshards; ++s) {
+        all_paths.push_back(Rcpp::as<std::string>(paths[s]));
+        all_compressed.push_back(is_compressed[s]);
+    }
+
+    // Using the first shard's header as the reference for all shards; any
+    // mismatches are caught by the name pre-fill check in the parser.
+    auto names = read_header(all_paths.front(), all_compressed.front());
+    size_t ncols = names.size();
+
+    BufferedFieldCreator creator;
+    std::vector<comservatory::Contents> contents(nshards);
+    run_parallel(nshards, num_threads, [&](size_t s) -> void {
+        auto& current = contents[s];
+        current.names = names;
+        comservatory::ReadOptions opt;
+        opt.creator = &creator;
+
+        try {
+            with_reader(all_paths[s], all_compressed[s], [&](byteme::Reader& reader) -> void {
+                comservatory::read(reader, current, opt);
+            });
+            if (current.names.size() != ncols) {
+                throw std::runtime_error("provided number of names is not equal to the number of header names");
+            }
+        } catch (std::exception& e) {
+            throw std::runtime_error("failed to parse '" + all_paths[s] + "'; " + std::string(e.what()));
+        }
+    });
+
+    std::vector<size_t> offsets(nshards + 1);
+    for (size_t s = 0; s < nshards; ++s) {
+        offsets[s + 1] = offsets[s] + contents[s].num_records();
+    }
+    size_t total = offsets.back();
+
+    Rcpp::List listed(ncols);
+    StatsCollector collected(ncols);
+    std::vector<ColumnStats> shard_stats(nshards);
+    auto combine_stats = [&]() -> ColumnStats {
+        ColumnStats combined;
+        for (const auto& current : shard_stats) {
+            combined.merge(current);
+        }
+        return combined;
+    };
+
+    for (size_t c = 0; c < ncols; ++c) {
+        comservatory::Type type = comservatory::UNKNOWN;
+        for (size_t s = 0; s < nshards; ++s) {
+            type = reconcile(type, contents[s].fields[c]->type(), names[c]);
+        }
+
+        switch (type) {
+            case comservatory::STRING:
+                {
+                    Rcpp::CharacterVector out(total);
+                    ColumnStats stats;
+                    for (size_t s = 0; s < nshards; ++s) {
+                        const auto* field = contents[s].fields[c].get();
+                        size_t offset = offsets[s];
+                        if (field->type() == comservatory::UNKNOWN) {
+                            for (size_t i = 0, end = field->size(); i < end; ++i) {
+                                out[offset + i] = NA_STRING;
+                            }
+                            stats.num_missing += field->size();
+                            continue;
+                        }
+                        const auto* sfield = static_cast<const BufferedStringField*>(field);
+                        for (size_t i = 0, end = sfield->values.size(); i < end; ++i) {
+                            if (sfield->missing[i]) {
+                                out[offset + i] = NA_STRING;
+                                ++stats.num_missing;
+                            } else {
+                                out[offset + i] = sfield->values[i];
+                                stats.add(sfield->values[i]);
+                            }
+                        }
+                    }
+                    listed[c] = out;
+                    collected.set(c, stats, comservatory::STRING);
+                }
+                break;
+            case comservatory::NUMBER:
+                {
+                    Rcpp::NumericVector out(total, NA_REAL);
+                    double* ptr = out.begin();
+                    run_parallel(nshards, num_threads, [&](size_t s) -> void {
+                        copy_shard<double>(contents[s].fields[c].get(), ptr + offsets[s]);
+                        shard_stats[s] = compute_stats(ptr + offsets[s], offsets[s + 1] - offsets[s]);
+                    });
+
+                    auto stats = combine_stats();
+                    collected.set(c, stats, comservatory::NUMBER);
+                    if (c < static_cast<size_t>(narrow_integers.size()) && narrow_integers[c] == 1 && can_narrow(stats)) {
+                        Rcpp::IntegerVector narrowed(total);
+                        int* nptr = narrowed.begin();
+                        run_parallel(nshards, num_threads, [&](size_t s) -> void {
+                            for (size_t i = offsets[s], end = offsets[s + 1]; i < end; ++i) {
+                                nptr[i] = (ISNA(ptr[i]) ? NA_INTEGER : static_cast<int>(ptr[i]));
+                            }
+                        });
+                        listed[c] = narrowed;
+                    } else {
+                        listed[c] = out;
+                    }
+                }
+                break;
+            case comservatory::BOOLEAN:
+                {
+                    Rcpp::LogicalVector out(total, NA_LOGICAL);
+                    int* ptr = out.begin();
+                    run_parallel(nshards, num_threads, [&](size_t s) -> void {
+                        copy_shard<int>(contents[s].fields[c].get(), ptr + offsets[s]);
+                        shard_stats[s] = compute_stats(ptr + offsets[s], offsets[s + 1] - offsets[s]);
+                    });
+                    listed[c] = out;
+                    collected.set(c, combine_stats(), comservatory::BOOLEAN);
+                }
+                break;
+            case comservatory::COMPLEX:
+                {
+                    Rcomplex na;
+                    na.r = NA_REAL;
+                    na.i = NA_REAL;
+                    Rcpp::ComplexVector out(total, na);
+                    Rcomplex* ptr = out.begin();
+                    run_parallel(nshards, num_threads, [&](size_t s) -> void {
+                        copy_shard<Rcomplex>(contents[s].fields[c].get(), ptr + offsets[s]);
+                        shard_stats[s] = compute_stats(ptr + offsets[s], offsets[s + 1] - offsets[s]);
+                    });
+                    listed[c] = out;
+                    collected.set(c, combine_stats(), comservatory::COMPLEX);
+                }
+                break;
+            default:
+                {
+                    Rcpp::LogicalVector out(total, NA_LOGICAL);
+                    listed[c] = out;
+                    collected.set_missing(c, total);
+                }
+        }
+
+        // Freeing memory as we go.
+        for (size_t s = 0; s < nshards; ++s) {
+            contents[s].fields[c].reset();
+        }
+    }
+
+    listed.names() = Rcpp::StringVector(names.begin(), names.end());
+    if (listed.size() == 0) {
+        listed.attr("num.records") = total;
+    }
+    listed.attr("column.stats") = collected.yield();
+
+    return listed;
+}
@@ -0,0 +1,406 @@
+#include "Rcpp.h"
+#include "H5Cpp.h"
+#include "PagedHdf5File.h"
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <functional>
+
+/**
+ * Native loader for the legacy 'hdf5_data_frame' format. This opens the file
+ * once and reads each requested column along with its missing placeholder,
+ * replicating the semantics of h5_cast(expected.type=NULL,
+ * respect.nan.payload=TRUE) followed by the atomic casts in
+ * .coerce_df_column_type(). Anything that can't be cast natively (e.g.,
+ * factor codes, dates) is returned as-is for the R-side coercion to handle.
+ */
+
+namespace {
+
+enum class Declared { OTHER, INTEGER, NUMBER, BOOLEAN };
+
+Declared parse_declared(const std::string& type) {
+    if (type == "integer") {
+        return Declared::INTEGER;
+    } else if (type == "number") {
+        return Declared::NUMBER;
+    } else if (type == "boolean") {
+        return Declared::BOOLEAN;
+    }
+    return Declared::OTHER;
+}
+
+bool fits_in_int32(const H5::IntType& itype) {
+    auto size = itype.getSize();
+    if (itype.getSign() == H5T_SGN_NONE) {
+        return size < 4;
+    } else {
+        return size <= 4;
+    }
+}
+
+std::vector<std::string> load_strings(const H5::StrType& stype, hsize_t len, std::function<void(const H5::DataType&, void*)> reader) {
+    std::vector<std::string> output;
+    output.reserve(len);
+
+    if (stype.isVariableStr()) {
+        std::vector<char*> buffer(len);
+        reader(stype, buffer.data());
+        for (hsize_t i = 0; i < len; ++i) {
+            output.emplace_back(buffer[i] == NULL ? "" : buffer[i]);
+        }
+
+        H5::DataSpace mspace(1, &len);
+        H5Dvlen_reclaim(stype.getId(), mspace.getId(), H5P_DEFAULT, buffer.data());
+
+    } else {
+        size_t size = stype.getSize();
+        std::vector<char> buffer(size * len);
+        reader(stype, buffer.data());
+        for (hsize_t i = 0; i < len; ++i) {
+            const char* start = buffer.data() + i * size;
+            output.emplace_back(start, strnlen(start, size));
+        }
+    }
+
+    return output;
+}
+
+struct Placeholder {
+    bool present = false;
+    bool is_string = false;
+
+    // For numeric placeholders; 'is_na' indicates that R would consider this to be NA.
+    double value = 0;
+    bool is_na = false;
+    bool is_nan = false; // i.e., NaN but not R's NA.
+
+    std::string string_value;
+};
+
+Placeholder load_placeholder(const H5::DataSet& dhandle) {
+    Placeholder output;
+    const char* name = "missing-value-placeholder";
+    if (!dhandle.attrExists(name)) {
+        return output;
+    }
+
+    output.present = true;
+    auto ahandle = dhandle.openAttribute(name);
+    if (ahandle.getSpace().getSimpleExtentNpoints() != 1) {
+        throw std::runtime_error("expected a scalar missing placeholder attribute");
+    }
+
+    auto aclass = ahandle.getTypeClass();
+    if (aclass == H5T_STRING) {
+        output.is_string = true;
+        auto stype = ahandle.getStrType();
+        auto vals = load_strings(stype, 1, [&](const H5::DataType& mem, void* buf) -> void { ahandle.read(mem, buf); });
+        output.string_value = vals.front();
+
+    } else if (aclass == H5T_INTEGER) {
+        auto itype = ahandle.getIntType();
+        if (fits_in_int32(itype)) {
+            int val;
+            ahandle.read(H5::PredType::NATIVE_INT, &val);
+            output.is_na = (val == NA_INTEGER);
+            output.value = val;
+        } else {
+            ahandle.read(H5::PredType::NATIVE_DOUBLE, &output.value);
+        }
+
+    } else if (aclass == H5T_FLOAT) {
+        ahandle.read(H5::PredType::NATIVE_DOUBLE, &output.value);
+        output.is_na = std::isnan(output.value);
+        output.is_nan = output.is_na && !R_IsNA(output.value);
+
+    } else {
+        throw std::runtime_error("unsupported type for the missing placeholder attribute");
+    }
+
+    return output;
+}
+
+SEXP cast_doubles(std::vector<double>& contents, Declared declared) {
+    if (declared == Declared::BOOLEAN) {
+        Rcpp::LogicalVector output(contents.size());
+        auto oIt = output.begin();
+        for (auto x : contents) {
+            *oIt = (std::isnan(x) ? NA_LOGICAL : (x != 0));
+            ++oIt;
+        }
+        return output;
+    }
+
+    if (declared == Declared::INTEGER) {
+        // Only casting if every value can be exactly represented as an
+        // integer; otherwise we leave it to R to apply its usual rules (and
+        // emit the relevant warnings). -2^31 is deliberately excluded as it
+        // indicates that the column must remain double-precision.
+        bool okay = true;
+        for (auto x : contents) {
+            if (std::isnan(x)) {
+                continue;
+            }
+            if (x <= -2147483648.0 || x > 2147483647.0 || x != std::trunc(x)) {
+                okay = false;
+                break;
+            }
+        }
+
+        if (okay) {
+            Rcpp::IntegerVector output(contents.size());
+            auto oIt = output.begin();
+            for (auto x : contents) {
+                *oIt = (std::isnan(x) ? NA_INTEGER : static_cast<int>(x));
+                ++oIt;
+            }
+            return output;
+        }
+    }
+
+    return Rcpp::NumericVector(contents.begin(), contents.end());
+}
+
+SEXP load_integer_column(const H5::DataSet& dhandle, hsize_t len, Declared declared) {
+    auto placeholder = load_placeholder(dhandle);
+    if (placeholder.is_string) {
+        throw std::runtime_error("missing placeholder should not be a string for an integer dataset");
+    }
+
+    auto itype = dhandle.getIntType();
+    if (!fits_in_int32(itype)) {
+        std::vector<double> contents(len);
+        dhandle.read(contents.data(), H5::PredType::NATIVE_DOUBLE);
+        if (placeholder.present && !placeholder.is_na) {
+            for (auto& x : contents) {
+                if (x == placeholder.value) {
+                    x = NA_REAL;
+                }
+            }
+        }
+        return cast_doubles(contents, declared);
+    }
+
+    std::vector<int> contents(len);
+    dhandle.read(contents.data(), H5::PredType::NATIVE_INT);
+
+    if (placeholder.present && placeholder.is_na) {
+        // No-op as the placeholder is already R's NA for integers.
+    } else {
+        bool has_min = false;
+        for (auto x : contents) {
+            if (x == NA_INTEGER) {
+                has_min = true;
+                break;
+            }
+        }
+
+        if (has_min) {
+            // Promoting to double so that -2^31 can be represented as itself.
+            std::vector<double> promoted(contents.begin(), contents.end());
+            if (placeholder.present) {
+                for (auto& x : promoted) {
+                    if (x == placeholder.value) {
+                        x = NA_REAL;
+                    }
+                }
+            }
+
+            // No further casting here, as h5_cast() skips it for converted vectors.
+            if (declared == Declared::BOOLEAN) {
+                return cast_doubles(promoted, declared);
+            }
+            return Rcpp::NumericVector(promoted.begin(), promoted.end());
+        }
+
+        if (placeholder.present) {
+            for (auto& x : contents) {
+                if (x == placeholder.value) {
+                    x = NA_INTEGER;
+                }
+            }
+        }
+    }
+
+    if (declared == Declared::NUMBER) {
+        Rcpp::NumericVector output(len);
+        auto oIt = output.begin();
+        for (auto x : contents) {
+            *oIt = (x == NA_INTEGER ? NA_REAL : static_cast<double>(x));
+            ++oIt;
+        }
+        return output;
+
+    } else if (declared == Declared::BOOLEAN) {
+        Rcpp::LogicalVector output(len);
+        auto oIt = output.begin();
+        for (auto x : contents) {
+            *oIt = (x == NA_INTEGER ? NA_LOGICAL : (x != 0));
+            ++oIt;
+        }
+        return output;
+    }
+
+    return Rcpp::IntegerVector(contents.begin(), contents.end());
+}
+
+SEXP load_float_column(const H5::DataSet& dhandle, hsize_t len, Declared declared) {
+    auto placeholder = load_placeholder(dhandle);
+    if (placeholder.is_string) {
+        throw std::runtime_error("missing placeholder should not be a string for a floating-point dataset");
+    }
+
+    std::vector<double> contents(len);
+    dhandle.read(contents.data(), H5::PredType::NATIVE_DOUBLE);
+
+    if (!placeholder.present) {
+        // No-op.
+    } else if (placeholder.is_na) {
+        // Respecting the NaN payload, so we only need to convert all NaNs to
+        // missing if the placeholder itself is not R's NA.
+        if (placeholder.is_nan) {
+            for (auto& x : contents) {
+                if (std::isnan(x)) {
+                    x = NA_REAL;
+                }
+            }
+        }
+    } else {
+        for (auto& x : contents) {
+            if (x == placeholder.value) {
+                x = NA_REAL;
+            }
+        }
+    }
+
+    return cast_doubles(contents, declared);
+}
+
+SEXP load_string_column(const H5::DataSet& dhandle, hsize_t len) {
+    auto placeholder = load_placeholder(dhandle);
+    if (placeholder.present && !placeholder.is_string) {
+        throw std::runtime_error("missing placeholder should be a string for a string dataset");
+    }
+
+    auto stype = dhandle.getStrType();
+    auto contents = load_strings(stype, len, [&](const H5::DataType& mem, void* buf) -> void { dhandle.read(buf, mem); });
+    cetype_t enc = (stype.getCset() == H5T_CSET_UTF8 ? CE_UTF8 : CE_NATIVE);
+
+    Rcpp::CharacterVector output(len);
+    for (hsize_t i = 0; i < len; ++i) {
+        const auto& current = contents[i];
+        if (placeholder.present && current == placeholder.string_value) {
+            output[i] = NA_STRING;
+        } else {
+            output[i] = Rf_mkCharLenCE(current.c_str(), current.size(), enc);
+        }
+    }
+
+    return output;
+}
+
+SEXP load_string_vector(const H5::Group& ghandle, const std::string& name) {
+    auto dhandle = ghandle.openDataSet(name);
+    if (dhandle.getTypeClass() != H5T_STRING) {
+        throw std::runtime_error("expected '" + name + "' to be a string dataset");
+    }
+    hsize_t len = dhandle.getSpace().getSimpleExtentNpoints();
+    return load_string_column(dhandle, len);
+}
+
+}
+
+// [[Rcpp::export(rng=false)]]
+Rcpp::List load_hdf5_data_frame(std::string path, std::string group, Rcpp::IntegerVector columns, Rcpp::CharacterVector types, bool has_row_names) {
+    if (columns.size() != types.size()) {
+        throw std::runtime_error("'columns' and 'types' should have the same length");
+    }
+
+    // HDF5 handles are constructed directly, as their copy assignment is deprecated.
+    size_t ncols = columns.size();
+    auto open_error = [&](const H5::Exception& e) -> std::runtime_error {
+        return std::runtime_error("failed to open '" + group + "' in '" + path + "'; " + e.getDetailMsg());
+    };
+
+    auto fhandle = [&]() -> H5::H5File {
+        try {
+            return open_hdf5_file(path);
+        } catch (H5::Exception& e) {
+            throw open_error(e);
+        }
+    }();
+
+    auto ghandle = [&]() -> H5::Group {
+        try {
+            return fhandle.openGroup(group);
+        } catch (H5::Exception& e) {
+            throw open_error(e);
+        }
+    }();
+
+    auto dghandle = [&]() -> H5::Group {
+        if (!ncols) {
+            return H5::Group();
+        }
+        try {
+            return ghandle.openGroup("data");
+        } catch (H5::Exception& e) {
+            throw open_error(e);
+        }
+    }();
+
+    Rcpp::List output(ncols);
+
+    if (ncols) {
+
+        for (size_t c = 0; c < ncols; ++c) {
+            std::string dname = std::to_string(columns[c]);
+            if (!dghandle.exists(dname)) {
+                // Non-atomic columns are stored elsewhere; these are filled in by the caller.
+                continue;
+            }
+
+            try {
+                auto dhandle = dghandle.openDataSet(dname);
+                hsize_t len = dhandle.getSpace().getSimpleExtentNpoints();
+                Declared declared = parse_declared(Rcpp::as<std::string>(types[c]));
+
+                auto dclass = dhandle.getTypeClass();
+                if (dclass == H5T_INTEGER) {
+                    output[c] = load_integer_column(dhandle, len, declared);
+                } else if (dclass == H5T_FLOAT) {
+                    output[c] = load_float_column(dhandle, len, declared);
+                } else if (dclass == H5T_STRING) {
+                    output[c] = load_string_column(dhandle, len);
+                } else {
+                    throw std::runtime_error("unsupported HDF5 datatype class");
+                }
+
+            } catch (H5::Exception& e) {
+                throw std::runtime_error("failed to load column '" + dname + "'; " + e.getDetailMsg());
+            } catch (std::exception& e) {
+                throw std::runtime_error("failed to load column '" + dname + "'; " + std::string(e.what()));
+            }
+        }
+    }
+
+    Rcpp::RObject row_names;
+    if (has_row_names) {
+        try {
+            row_names = load_string_vector(ghandle, "row_names");
+        } catch (H5::Exception& e) {
+            throw std::runtime_error("failed to load row names; " + e.getDetailMsg());
+        }
+    }
+
+    Rcpp::List result(2);
+    result[0] = output;
+    result[1] = row_names;
+    result.names() = Rcpp::CharacterVector::create("columns", "row_names");
+    return result;
+}
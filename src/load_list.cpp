@@ -1,6 +1,10 @@
 #include "Rcpp.h"
 
 #include "uzuki2/uzuki2.hpp"
+#include "PrefetchFileReader.h"
+#include "JsonListStreamer.h"
+#include "Hdf5ListParser.h"
+#include "PagedHdf5File.h"
 
 template<class Input_>
 void scalarize(Input_& object, bool needs_marker) {
@@ -399,17 +403,25 @@ struct RExternals {
 };
 
 // [[Rcpp::export(rng=false)]]
-Rcpp::RObject load_list_hdf5(std::string file, std::string name, Rcpp::List obj) {
+Rcpp::RObject load_list_hdf5(std::string file, std::string name, Rcpp::List obj, bool packed) {
     RExternals others(obj);
-    auto ptr = uzuki2::hdf5::parse<RProvisioner>(file, name, std::move(others));
+    auto handle = open_hdf5_file(file);
+
+    // Regular lists are a special case of the packed layout without any
+    // 'packed' groups, so we use the same iterative parser for both.
+    Hdf5ListParser<RProvisioner, RExternals> parser(std::move(others), packed);
+    auto ptr = parser.parse(handle, name);
     return dynamic_cast<RBase*>(ptr.get())->extract_object();
 }
 
 // [[Rcpp::export(rng=false)]]
 Rcpp::RObject load_list_json(std::string file, Rcpp::List obj, bool parallel) {
-    uzuki2::json::Options opt;
-    opt.parallel = parallel;
     RExternals others(obj);
-    auto ptr = uzuki2::json::parse_file<RProvisioner>(file, std::move(others));
-    return dynamic_cast<RBase*>(ptr.get())->extract_object();
+    Rcpp::RObject output;
+    with_prefetching_reader(file, true, [&](byteme::Reader& reader) -> void {
+        JsonListStreamer<RProvisioner, RExternals> streamer(reader, std::move(others), parallel);
+        auto ptr = streamer.parse();
+        output = dynamic_cast<RBase*>(ptr.get())->extract_object();
+    });
+    return output;
 }
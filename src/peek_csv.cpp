@@ -0,0 +1,226 @@
+#include "Rcpp.h"
+#include "comservatory/comservatory.hpp"
+#include "byteme/GzipFileReader.hpp"
+#include "PrefetchFileReader.h"
+
+#include <fstream>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * Peeking at the start of a CSV to report its column names and types, without
+ * parsing the entire file. The number of records is extrapolated from the
+ * size of the first few records relative to the (uncompressed) file size.
+ */
+
+namespace {
+
+// Passes through bytes from the inner reader until we have seen a given number
+// of unquoted newlines, i.e., the header and the first few records.
+class RecordLimitedReader : public byteme::Reader {
+public:
+    RecordLimitedReader(byteme::Reader& r, size_t limit) : inner(r), remaining_lines(limit + 1) {}
+
+    bool load() {
+        if (finished) {
+            len = 0;
+            return false;
+        }
+
+        bool remaining = inner.load();
+        ptr = inner.buffer();
+        len = inner.available();
+
+        // Escaped quotes ("") toggle the state twice and are correctly ignored.
+        for (size_t i = 0; i < len; ++i) {
+            char c = ptr[i];
+            if (c == '"') {
+                in_quote = !in_quote;
+            } else if (c == '\n' && !in_quote) {
+                if (!header_done) {
+                    header_done = true;
+                    header_bytes = consumed + i + 1;
+                }
+                --remaining_lines;
+                if (remaining_lines == 0) {
+                    // If the file has exactly 'limit' records, nothing should
+                    // follow this newline. We can only check the next chunk
+                    // after the parser is done with this one, see check_end().
+                    if (i + 1 == len) {
+                        if (remaining) {
+                            probe_end = true;
+                        } else {
+                            exhausted = true;
+                        }
+                    }
+                    len = i + 1;
+                    consumed += len;
+                    finished = true;
+                    return false;
+                }
+            }
+        }
+
+        consumed += len;
+        if (!remaining) {
+            finished = true;
+            exhausted = true;
+        }
+        return remaining;
+    }
+
+    const unsigned char* buffer() const { return ptr; }
+
+    size_t available() const { return len; }
+
+    // Should only be called after parsing is complete, as this invalidates
+    // the buffer of the inner reader.
+    void check_end() {
+        if (!probe_end) {
+            return;
+        }
+        probe_end = false;
+        while (true) {
+            bool more = inner.load();
+            if (inner.available()) {
+                return;
+            }
+            if (!more) {
+                exhausted = true;
+                return;
+            }
+        }
+    }
+
+private:
+    byteme::Reader& inner;
+    const unsigned char* ptr = nullptr;
+    size_t len = 0;
+    size_t remaining_lines;
+    bool in_quote = false;
+    bool finished = false;
+    bool header_done = false;
+    bool probe_end = false;
+
+public:
+    size_t consumed = 0;
+    size_t header_bytes = 0;
+    bool exhausted = false;
+};
+
+// For Gzip files, the uncompressed size (modulo 2^32) is stored in the last
+// four bytes of the final member, see RFC 1952. For Zstandard files, the size
+// may be stored in the header of the first frame.
+double uncompressed_size(const std::string& path, FileCompression compression, size_t consumed) {
+    std::ifstream handle(path, std::ios::binary | std::ios::ate);
+    if (!handle) {
+        throw std::runtime_error("failed to open '" + path + "'");
+    }
+    double total = static_cast<double>(handle.tellg());
+    if (compression == FileCompression::NONE) {
+        return total;
+    }
+
+    if (compression == FileCompression::ZSTD) {
+#ifdef ALABASTER_HAS_ZSTD
+        std::vector<char> header(18); // i.e., the maximum size of a frame header.
+        handle.seekg(0, std::ios::beg);
+        handle.read(header.data(), header.size());
+        auto size = ZSTD_getFrameContentSize(header.data(), handle.gcount());
+        if (size != ZSTD_CONTENTSIZE_UNKNOWN && size != ZSTD_CONTENTSIZE_ERROR) {
+            return static_cast<double>(size);
+        }
+#endif
+        return NA_REAL;
+    }
+
+    if (total < 4) {
+        return NA_REAL;
+    }
+    handle.seekg(-4, std::ios::end);
+    unsigned char trailer[4];
+    handle.read(reinterpret_cast<char*>(trailer), 4);
+
+    uint32_t isize = 0;
+    for (int i = 3; i >= 0; --i) {
+        isize = (isize << 8) | trailer[i];
+    }
+
+    // Accounting for wrap-around in files larger than 4 GB.
+    double output = isize;
+    while (output < static_cast<double>(consumed)) {
+        output += 4294967296.0;
+    }
+    return output;
+}
+
+const char* type_to_string(comservatory::Type type) {
+    switch (type) {
+        case comservatory::STRING:
+            return "string";
+        case comservatory::NUMBER:
+            return "number";
+        case comservatory::BOOLEAN:
+            return "boolean";
+        case comservatory::COMPLEX:
+            return "complex";
+        default:
+            break;
+    }
+    return "unknown";
+}
+
+}
+
+// [[Rcpp::export(rng=false)]]
+Rcpp::List peek_csv(std::string path, bool is_compressed, int nrecords) {
+    comservatory::ReadOptions opt;
+    opt.validate_only = true;
+    comservatory::Contents contents;
+
+    size_t consumed = 0, header_bytes = 0;
+    bool exhausted = false;
+
+    auto fun = [&](byteme::Reader& reader) -> void {
+        RecordLimitedReader limited(reader, nrecords);
+        comservatory::read(limited, contents, opt);
+        limited.check_end();
+        consumed = limited.consumed;
+        header_bytes = limited.header_bytes;
+        exhausted = limited.exhausted;
+    };
+
+    with_prefetching_reader(path, is_compressed, fun);
+
+    size_t nfields = contents.num_fields();
+    Rcpp::CharacterVector types(nfields);
+    for (size_t f = 0; f < nfields; ++f) {
+        types[f] = type_to_string(contents.fields[f]->type());
+    }
+
+    size_t observed = contents.num_records();
+    double estimate = observed;
+    if (!exhausted) {
+        auto compression = detect_compression(path);
+        if (compression == FileCompression::GZIP && !is_compressed) {
+            compression = FileCompression::NONE;
+        }
+        double total = uncompressed_size(path, compression, consumed);
+        double record_bytes = consumed - header_bytes;
+        if (observed == 0 || record_bytes <= 0 || std::isnan(total)) {
+            estimate = NA_REAL;
+        } else {
+            estimate = std::max(static_cast<double>(observed), std::round(observed * (total - header_bytes) / record_bytes));
+        }
+    }
+
+    Rcpp::List output(5);
+    output[0] = Rcpp::StringVector(contents.names.begin(), contents.names.end());
+    output[1] = types;
+    output[2] = Rcpp::IntegerVector::create(observed);
+    output[3] = Rcpp::NumericVector::create(estimate);
+    output[4] = Rcpp::LogicalVector::create(exhausted);
+    output.names() = Rcpp::CharacterVector::create("names", "types", "peeked", "records", "exact");
+    return output;
+}
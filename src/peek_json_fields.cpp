@@ -0,0 +1,100 @@
+#include "Rcpp.h"
+#include "JsonPeeker.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+
+/**
+ * Cheap extraction of top-level fields from JSON metadata documents, to avoid
+ * fully parsing every file when we only need to know its '$schema', 'path' or
+ * 'is_child'. Only string and boolean values are reported; all other values
+ * (and any fields that were not requested) are skipped without allocation.
+ */
+
+namespace {
+
+void scan_fields(JsonPeeker& peeker, const std::unordered_map<std::string, size_t>& requested, std::vector<std::string>& output, std::vector<unsigned char>& found) {
+    peeker.scan_object([&](const std::string& key) -> void {
+        auto it = requested.find(key);
+        if (it == requested.end()) {
+            peeker.skip_value();
+            return;
+        }
+
+        size_t index = it->second;
+        char c = peeker.peek();
+        if (c == '"') {
+            output[index].clear();
+            peeker.parse_string(&(output[index]));
+            found[index] = true;
+        } else if (peeker.consume_literal("true", 4)) {
+            output[index] = "true";
+            found[index] = true;
+        } else if (peeker.consume_literal("false", 5)) {
+            output[index] = "false";
+            found[index] = true;
+        } else {
+            peeker.skip_value();
+        }
+    });
+}
+
+}
+
+// [[Rcpp::export(rng=false)]]
+Rcpp::List peek_json_fields(Rcpp::CharacterVector paths, Rcpp::CharacterVector fields) {
+    size_t nfields = fields.size();
+    std::unordered_map<std::string, size_t> requested;
+    for (size_t f = 0; f < nfields; ++f) {
+        requested[Rcpp::as<std::string>(fields[f])] = f;
+    }
+
+    size_t npaths = paths.size();
+    std::vector<Rcpp::CharacterVector> collected;
+    collected.reserve(nfields);
+    for (size_t f = 0; f < nfields; ++f) {
+        collected.emplace_back(npaths);
+    }
+
+    std::vector<std::string> values(nfields);
+    std::vector<unsigned char> found(nfields);
+    std::string contents;
+
+    for (size_t p = 0; p < npaths; ++p) {
+        std::string current = Rcpp::as<std::string>(paths[p]);
+        std::ifstream handle(current, std::ios::binary);
+        if (!handle) {
+            throw std::runtime_error("failed to open '" + current + "'");
+        }
+        std::stringstream ss;
+        ss << handle.rdbuf();
+        contents = ss.str();
+
+        std::fill(found.begin(), found.end(), false);
+        try {
+            JsonPeeker peeker(contents);
+            scan_fields(peeker, requested, values, found);
+        } catch (std::exception& e) {
+            throw std::runtime_error("failed to scan '" + current + "'; " + std::string(e.what()));
+        }
+
+        for (size_t f = 0; f < nfields; ++f) {
+            if (found[f]) {
+                collected[f][p] = Rf_mkCharLenCE(values[f].c_str(), values[f].size(), CE_UTF8);
+            } else {
+                collected[f][p] = NA_STRING;
+            }
+        }
+    }
+
+    Rcpp::List output(nfields);
+    for (size_t f = 0; f < nfields; ++f) {
+        output[f] = collected[f];
+    }
+    output.names() = fields;
+    return output;
+}
@@ -0,0 +1,298 @@
+#include "Rcpp.h"
+#include "H5Cpp.h"
+#include "PagedHdf5File.h"
+#include "JsonPeeker.h"
+#include "byteme/GzipFileReader.hpp"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * Reporting the top-level structure of an uzuki2 list, i.e., the type, length
+ * and name of each of its elements, without loading any of the leaf values.
+ */
+
+namespace {
+
+struct ListStructure {
+    std::vector<std::string> types;
+    std::vector<int> lengths;
+    std::vector<unsigned char> scalars;
+    bool named = false;
+    std::vector<std::string> names;
+
+    Rcpp::List yield() const {
+        Rcpp::List output(4);
+        if (named) {
+            output[0] = Rcpp::CharacterVector(names.begin(), names.end());
+        }
+        output[1] = Rcpp::CharacterVector(types.begin(), types.end());
+        output[2] = Rcpp::IntegerVector(lengths.begin(), lengths.end());
+        output[3] = Rcpp::LogicalVector(scalars.begin(), scalars.end());
+        output.names() = Rcpp::CharacterVector::create("names", "types", "lengths", "scalar");
+        return output;
+    }
+};
+
+/** JSON lists. **/
+
+std::string read_whole_file(const std::string& path) {
+    unsigned char magic[2] = { 0, 0 };
+    {
+        std::ifstream handle(path, std::ios::binary);
+        if (!handle) {
+            throw std::runtime_error("failed to open '" + path + "'");
+        }
+        handle.read(reinterpret_cast<char*>(magic), 2);
+    }
+
+    std::string contents;
+    auto fun = [&](byteme::Reader& reader) -> void {
+        bool remaining;
+        do {
+            remaining = reader.load();
+            auto ptr = reinterpret_cast<const char*>(reader.buffer());
+            contents.insert(contents.end(), ptr, ptr + reader.available());
+        } while (remaining);
+    };
+
+    if (magic[0] == 0x1f && magic[1] == 0x8b) {
+        byteme::GzipFileReader reader(path);
+        fun(reader);
+    } else {
+        byteme::RawFileReader reader(path);
+        fun(reader);
+    }
+
+    return contents;
+}
+
+void scan_list_element(JsonPeeker& peeker, ListStructure& output) {
+    std::string type;
+    int length = NA_INTEGER;
+    bool scalar = false;
+
+    peeker.scan_object([&](const std::string& key) -> void {
+        if (key == "type" && peeker.peek() == '"') {
+            peeker.parse_string(&type);
+        } else if (key == "values") {
+            if (peeker.peek() == '[') {
+                length = peeker.scan_array([&]() -> void { peeker.skip_value(); });
+            } else {
+                peeker.skip_value();
+                length = 1;
+                scalar = true;
+            }
+        } else {
+            peeker.skip_value();
+        }
+    });
+
+    if (type == "nothing") {
+        length = 0;
+    } else if (type == "external") {
+        length = NA_INTEGER;
+    }
+
+    output.types.push_back(type);
+    output.lengths.push_back(length);
+    output.scalars.push_back(scalar);
+}
+
+ListStructure peek_json(const std::string& contents) {
+    ListStructure output;
+    JsonPeeker peeker(contents);
+
+    std::string type;
+    peeker.scan_object([&](const std::string& key) -> void {
+        if (key == "type" && peeker.peek() == '"') {
+            peeker.parse_string(&type);
+        } else if (key == "values" && peeker.peek() == '[') {
+            peeker.scan_array([&]() -> void { scan_list_element(peeker, output); });
+        } else if (key == "names" && peeker.peek() == '[') {
+            output.named = true;
+            peeker.scan_array([&]() -> void {
+                if (peeker.peek() != '"') {
+                    peeker.fail("expected a string in 'names'");
+                }
+                output.names.emplace_back();
+                peeker.parse_string(&(output.names.back()));
+            });
+        } else {
+            peeker.skip_value();
+        }
+    });
+
+    if (type != "list") {
+        throw std::runtime_error("top-level object should be a list");
+    }
+    if (output.named && output.names.size() != output.types.size()) {
+        throw std::runtime_error("length of 'names' should be equal to the number of list elements");
+    }
+    return output;
+}
+
+/** HDF5 lists. **/
+
+std::string read_string_attribute(const H5::H5Object& handle, const char* name) {
+    if (!handle.attrExists(name)) {
+        throw std::runtime_error("expected a '" + std::string(name) + "' attribute");
+    }
+    auto ahandle = handle.openAttribute(name);
+    if (ahandle.getTypeClass() != H5T_STRING) {
+        throw std::runtime_error("expected the '" + std::string(name) + "' attribute to be a string");
+    }
+    std::string output;
+    ahandle.read(ahandle.getStrType(), output);
+    return output;
+}
+
+std::vector<std::string> read_string_dataset(const H5::DataSet& dhandle) {
+    if (dhandle.getTypeClass() != H5T_STRING) {
+        throw std::runtime_error("expected a string dataset");
+    }
+
+    auto stype = dhandle.getStrType();
+    hsize_t len = dhandle.getSpace().getSimpleExtentNpoints();
+    std::vector<std::string> output;
+    output.reserve(len);
+
+    if (stype.isVariableStr()) {
+        std::vector<char*> buffer(len);
+        dhandle.read(buffer.data(), stype);
+        for (hsize_t i = 0; i < len; ++i) {
+            output.emplace_back(buffer[i] == NULL ? "" : buffer[i]);
+        }
+        H5::DataSpace mspace(1, &len);
+        H5Dvlen_reclaim(stype.getId(), mspace.getId(), H5P_DEFAULT, buffer.data());
+    } else {
+        size_t size = stype.getSize();
+        std::vector<char> buffer(size * len);
+        dhandle.read(buffer.data(), stype);
+        for (hsize_t i = 0; i < len; ++i) {
+            const char* start = buffer.data() + i * size;
+            output.emplace_back(start, strnlen(start, size));
+        }
+    }
+
+    return output;
+}
+
+std::vector<int> read_integer_dataset(const H5::DataSet& dhandle) {
+    if (dhandle.getTypeClass() != H5T_INTEGER) {
+        throw std::runtime_error("expected an integer dataset");
+    }
+    std::vector<int> output(dhandle.getSpace().getSimpleExtentNpoints());
+    if (!output.empty()) {
+        dhandle.read(output.data(), H5::PredType::NATIVE_INT);
+    }
+    return output;
+}
+
+ListStructure peek_hdf5(const std::string& path, const std::string& name) {
+    auto fhandle = open_hdf5_file(path);
+    auto ghandle = fhandle.openGroup(name);
+
+    if (read_string_attribute(ghandle, "uzuki_object") != "list") {
+        throw std::runtime_error("top-level object should be a list");
+    }
+
+    ListStructure output;
+    auto dhandle = ghandle.openGroup("data");
+    hsize_t nchildren = dhandle.getNumObjs();
+
+    // Scalar leaves in the packed layout are described by the 'packed'
+    // subgroup, see Hdf5ListParser.h for details.
+    std::vector<int> packed_index, packed_type;
+    if (ghandle.exists("packed")) {
+        auto phandle = ghandle.openGroup("packed");
+        packed_index = read_integer_dataset(phandle.openDataSet("index"));
+        packed_type = read_integer_dataset(phandle.openDataSet("type"));
+        if (packed_index.size() != packed_type.size()) {
+            throw std::runtime_error("length of 'packed/type' should be equal to that of 'packed/index'");
+        }
+        nchildren += packed_index.size();
+    }
+    size_t packed_at = 0;
+
+    for (hsize_t i = 0; i < nchildren; ++i) {
+        if (packed_at < packed_index.size() && static_cast<hsize_t>(packed_index[packed_at]) == i) {
+            static const char* packed_names[] = { "nothing", "integer", "number", "boolean", "string", "string", "string" };
+            int type = packed_type[packed_at];
+            if (type < 0 || type > 6) {
+                throw std::runtime_error("unknown type " + std::to_string(type) + " in 'packed/type'");
+            }
+            output.types.push_back(packed_names[type]);
+            output.lengths.push_back(type == 0 ? 0 : 1);
+            output.scalars.push_back(type != 0);
+            ++packed_at;
+            continue;
+        }
+
+        std::string cname = std::to_string(i);
+        if (!dhandle.exists(cname) || dhandle.childObjType(cname) != H5O_TYPE_GROUP) {
+            throw std::runtime_error("expected a group at 'data/" + cname + "'");
+        }
+        auto chandle = dhandle.openGroup(cname);
+        auto object = read_string_attribute(chandle, "uzuki_object");
+
+        int length = NA_INTEGER;
+        bool scalar = false;
+        std::string type = object;
+
+        if (object == "vector") {
+            type = read_string_attribute(chandle, "uzuki_type");
+            auto vhandle = chandle.openDataSet("data");
+            auto vspace = vhandle.getSpace();
+            length = vspace.getSimpleExtentNpoints();
+            scalar = (vspace.getSimpleExtentNdims() == 0);
+        } else if (object == "list") {
+            length = chandle.openGroup("data").getNumObjs();
+            if (chandle.exists("packed")) {
+                length += chandle.openGroup("packed").openDataSet("index").getSpace().getSimpleExtentNpoints();
+            }
+        } else if (object == "nothing") {
+            length = 0;
+        }
+
+        output.types.push_back(type);
+        output.lengths.push_back(length);
+        output.scalars.push_back(scalar);
+    }
+
+    if (ghandle.exists("names")) {
+        output.named = true;
+        output.names = read_string_dataset(ghandle.openDataSet("names"));
+        if (output.names.size() != output.types.size()) {
+            throw std::runtime_error("length of 'names' should be equal to the number of list elements");
+        }
+    }
+
+    return output;
+}
+
+}
+
+// [[Rcpp::export(rng=false)]]
+Rcpp::List peek_list_json(std::string path) {
+    try {
+        auto contents = read_whole_file(path);
+        return peek_json(contents).yield();
+    } catch (std::exception& e) {
+        throw std::runtime_error("failed to peek at '" + path + "'; " + std::string(e.what()));
+    }
+}
+
+// [[Rcpp::export(rng=false)]]
+Rcpp::List peek_list_hdf5(std::string path, std::string name) {
+    try {
+        return peek_hdf5(path, name).yield();
+    } catch (H5::Exception& e) {
+        throw std::runtime_error("failed to peek at '" + path + "'; " + e.getDetailMsg());
+    } catch (std::exception& e) {
+        throw std::runtime_error("failed to peek at '" + path + "'; " + std::string(e.what()));
+    }
+}
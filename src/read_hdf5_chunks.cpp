@@ -0,0 +1,143 @@
+#include "Rcpp.h"
+#include "ParallelChunkReader.h"
+#include "PagedHdf5File.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <climits>
+#include <cmath>
+
+// Returns NULL if the dataset is not supported, in which case the caller
+// should fall back to the usual HDF5 read.
+// [[Rcpp::export(rng=false)]]
+SEXP read_hdf5_chunks_parallel(std::string path, std::string name, int num_threads) {
+    auto fhandle = open_hdf5_file(path);
+    auto dhandle = fhandle.openDataSet(name);
+
+    auto layout = parallel_chunks::inspect(dhandle);
+    if (layout.kind == parallel_chunks::Kind::UNSUPPORTED) {
+        return R_NilValue;
+    }
+
+    if (layout.as_double()) {
+        Rcpp::NumericVector output(layout.length);
+        parallel_chunks::read(dhandle, layout, static_cast<double*>(output.begin()), num_threads);
+        return output;
+    } else {
+        Rcpp::IntegerVector output(layout.length);
+        parallel_chunks::read(dhandle, layout, static_cast<int*>(output.begin()), num_threads);
+        return output;
+    }
+}
+
+/**
+ * Reading multiple datasets (e.g., data frame columns) with their chunks
+ * decoded concurrently. Missing placeholders are also replaced by the worker
+ * threads, replicating h5_cast(respect.nan.payload=FALSE) without the final
+ * coercion to the expected type. Each entry of the output is NULL if the
+ * dataset is not supported, or if it contains values that h5_cast() would
+ * handle specially, i.e., -2^31 in integers without an equivalent
+ * placeholder. In such cases, the caller should fall back to the usual read.
+ */
+// [[Rcpp::export(rng=false)]]
+Rcpp::List read_hdf5_columns_parallel(std::string path, Rcpp::CharacterVector names, Rcpp::List placeholders, int num_threads) {
+    auto fhandle = open_hdf5_file(path);
+    size_t ncols = names.size();
+    Rcpp::List output(ncols);
+
+    // Reserving to avoid invalidating the pointers in each task.
+    std::vector<H5::DataSet> dhandles;
+    dhandles.reserve(ncols);
+    std::vector<parallel_chunks::Layout> layouts;
+    layouts.reserve(ncols);
+    std::vector<parallel_chunks::Task> tasks;
+    tasks.reserve(ncols);
+    std::vector<size_t> columns;
+    columns.reserve(ncols);
+    std::unique_ptr<std::atomic<bool>[]> fallback(new std::atomic<bool>[ncols]);
+
+    for (size_t c = 0; c < ncols; ++c) {
+        fallback[c] = false;
+
+        SEXP placeholder = placeholders[c];
+        bool has_placeholder = !Rf_isNull(placeholder);
+        if (has_placeholder) {
+            auto ptype = TYPEOF(placeholder);
+            if ((ptype != INTSXP && ptype != LGLSXP && ptype != REALSXP) || Rf_xlength(placeholder) != 1) {
+                continue;
+            }
+        }
+        double value = (has_placeholder ? Rf_asReal(placeholder) : 0);
+        bool na_placeholder = has_placeholder && std::isnan(value);
+
+        dhandles.push_back(fhandle.openDataSet(Rcpp::as<std::string>(names[c])));
+        layouts.push_back(parallel_chunks::inspect(dhandles.back()));
+        const auto& layout = layouts.back();
+        if (layout.kind == parallel_chunks::Kind::UNSUPPORTED) {
+            continue;
+        }
+
+        parallel_chunks::Task task;
+        task.dhandle = &(dhandles.back());
+        task.layout = &layout;
+        std::atomic<bool>* failed = fallback.get() + c;
+
+        if (layout.as_double()) {
+            Rcpp::NumericVector current(layout.length);
+            double* ptr = static_cast<double*>(current.begin());
+            task.output = ptr;
+            output[c] = current;
+
+            if (na_placeholder) {
+                task.finish = [ptr](hsize_t start, hsize_t len) -> void {
+                    for (hsize_t i = start, end = start + len; i < end; ++i) {
+                        if (std::isnan(ptr[i])) {
+                            ptr[i] = NA_REAL;
+                        }
+                    }
+                };
+            } else if (has_placeholder) {
+                task.finish = [ptr,value](hsize_t start, hsize_t len) -> void {
+                    for (hsize_t i = start, end = start + len; i < end; ++i) {
+                        if (ptr[i] == value) {
+                            ptr[i] = NA_REAL;
+                        }
+                    }
+                };
+            }
+
+        } else {
+            Rcpp::IntegerVector current(layout.length);
+            int* ptr = static_cast<int*>(current.begin());
+            task.output = ptr;
+            output[c] = current;
+
+            // An NA placeholder is already R's missing integer, so nothing needs to be done.
+            if (!na_placeholder) {
+                task.finish = [ptr,value,has_placeholder,failed](hsize_t start, hsize_t len) -> void {
+                    for (hsize_t i = start, end = start + len; i < end; ++i) {
+                        if (has_placeholder && ptr[i] == value) {
+                            ptr[i] = NA_INTEGER;
+                        } else if (ptr[i] == INT_MIN) {
+                            *failed = true;
+                        }
+                    }
+                };
+            }
+        }
+
+        tasks.push_back(std::move(task));
+        columns.push_back(c);
+    }
+
+    parallel_chunks::read_all(tasks, num_threads);
+
+    for (auto c : columns) {
+        if (fallback[c]) {
+            output[c] = R_NilValue;
+        }
+    }
+    return output;
+}
@@ -0,0 +1,191 @@
+#include "Rcpp.h"
+#include "PagedHdf5File.h"
+#include <Rversion.h>
+
+#include <string>
+#include <cstddef>
+
+/**
+ * Memory-mapping uncompressed contiguous datasets into ALTREP vectors. This is
+ * only possible if the on-disk representation of the dataset is the same as
+ * R's in-memory representation, i.e., 32-bit integers or 64-bit floats in the
+ * native byte order. The file is mapped privately with copy-on-write, so any
+ * in-place modification of the vector (e.g., by h5_cast()) only affects the
+ * modified pages in the current process and never touches the file.
+ */
+
+#if R_VERSION >= R_Version(3, 6, 0) && !defined(_WIN32)
+#define ALABASTER_HAS_MAPPED_VECTORS
+#endif
+
+#ifdef ALABASTER_HAS_MAPPED_VECTORS
+// Altrep.h uses 'class' as an identifier, which is reserved in C++.
+#define class klass
+extern "C" {
+#include <R_ext/Altrep.h>
+}
+#undef class
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+struct Mapping {
+    void* base;
+    size_t length;
+    size_t delta;
+    R_xlen_t size;
+};
+
+R_altrep_class_t mapped_integer_class;
+R_altrep_class_t mapped_real_class;
+
+Mapping* get_mapping(SEXP x) {
+    return static_cast<Mapping*>(R_ExternalPtrAddr(R_altrep_data1(x)));
+}
+
+void finalize_mapping(SEXP ptr) {
+    auto mapping = static_cast<Mapping*>(R_ExternalPtrAddr(ptr));
+    if (mapping) {
+        munmap(mapping->base, mapping->length);
+        delete mapping;
+        R_ClearExternalPtr(ptr);
+    }
+}
+
+R_xlen_t mapped_length(SEXP x) {
+    return get_mapping(x)->size;
+}
+
+void* mapped_dataptr(SEXP x, Rboolean) {
+    auto mapping = get_mapping(x);
+    return static_cast<unsigned char*>(mapping->base) + mapping->delta;
+}
+
+const void* mapped_dataptr_or_null(SEXP x) {
+    return mapped_dataptr(x, FALSE);
+}
+
+int mapped_integer_elt(SEXP x, R_xlen_t i) {
+    return static_cast<const int*>(mapped_dataptr_or_null(x))[i];
+}
+
+double mapped_real_elt(SEXP x, R_xlen_t i) {
+    return static_cast<const double*>(mapped_dataptr_or_null(x))[i];
+}
+
+Rboolean mapped_inspect(SEXP x, int, int, int, void (*)(SEXP, int, int, int)) {
+    Rprintf("alabaster.base memory-mapped vector (length %lld)\n", static_cast<long long>(mapped_length(x)));
+    return TRUE;
+}
+
+// Serialization and duplication fall back to the defaults, which create a
+// regular vector from the mapped contents.
+void register_mapped_methods(R_altrep_class_t cls) {
+    R_set_altrep_Length_method(cls, mapped_length);
+    R_set_altrep_Inspect_method(cls, mapped_inspect);
+    R_set_altvec_Dataptr_method(cls, mapped_dataptr);
+    R_set_altvec_Dataptr_or_null_method(cls, mapped_dataptr_or_null);
+}
+
+}
+#endif
+
+// [[Rcpp::init]]
+void init_mapped_vectors(DllInfo* dll) {
+#ifdef ALABASTER_HAS_MAPPED_VECTORS
+    mapped_integer_class = R_make_altinteger_class("mapped_integer", "alabaster.base", dll);
+    register_mapped_methods(mapped_integer_class);
+    R_set_altinteger_Elt_method(mapped_integer_class, mapped_integer_elt);
+
+    mapped_real_class = R_make_altreal_class("mapped_real", "alabaster.base", dll);
+    register_mapped_methods(mapped_real_class);
+    R_set_altreal_Elt_method(mapped_real_class, mapped_real_elt);
+#endif
+}
+
+// Returns NULL if the dataset cannot be mapped, in which case the caller
+// should fall back to the usual HDF5 read.
+// [[Rcpp::export(rng=false)]]
+SEXP read_hdf5_mapped(std::string path, std::string name) {
+#ifdef ALABASTER_HAS_MAPPED_VECTORS
+    bool is_integer;
+    hsize_t size;
+    haddr_t offset;
+    // Any HDF5 errors are deferred to the regular reader, which reports them properly.
+    try {
+        auto fhandle = open_hdf5_file(path);
+        auto dhandle = fhandle.openDataSet(name);
+
+        auto dtype = dhandle.getDataType();
+        if (dtype == H5::PredType::NATIVE_INT32) {
+            is_integer = true;
+        } else if (dtype == H5::PredType::NATIVE_DOUBLE) {
+            is_integer = false;
+        } else {
+            return R_NilValue;
+        }
+
+        auto dspace = dhandle.getSpace();
+        if (dspace.getSimpleExtentNdims() != 1) {
+            return R_NilValue;
+        }
+        dspace.getSimpleExtentDims(&size);
+        if (size == 0) {
+            return R_NilValue;
+        }
+
+        auto dcpl = dhandle.getCreatePlist();
+        if (dcpl.getLayout() != H5D_CONTIGUOUS || dcpl.getExternalCount() != 0) {
+            return R_NilValue;
+        }
+
+        // This is an absolute offset, i.e., it already includes the user block.
+        offset = H5Dget_offset(dhandle.getId());
+        if (offset == HADDR_UNDEF) {
+            return R_NilValue;
+        }
+    } catch (H5::Exception&) {
+        return R_NilValue;
+    }
+
+    // R assumes that its vectors are aligned to the size of their type.
+    size_t type_size = (is_integer ? sizeof(int) : sizeof(double));
+    if (offset % type_size != 0) {
+        return R_NilValue;
+    }
+    size_t nbytes = size * type_size;
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return R_NilValue;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<hsize_t>(info.st_size) < offset + nbytes) {
+        ::close(fd);
+        return R_NilValue;
+    }
+
+    size_t page_size = ::sysconf(_SC_PAGESIZE);
+    size_t delta = offset % page_size;
+    size_t length = nbytes + delta;
+    void* base = ::mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, offset - delta);
+    ::close(fd); // the mapping holds its own reference to the file.
+    if (base == MAP_FAILED) {
+        return R_NilValue;
+    }
+
+    auto mapping = new Mapping{ base, length, delta, static_cast<R_xlen_t>(size) };
+    SEXP ptr = PROTECT(R_MakeExternalPtr(mapping, R_NilValue, R_NilValue));
+    R_RegisterCFinalizerEx(ptr, finalize_mapping, TRUE);
+    SEXP output = R_new_altrep(is_integer ? mapped_integer_class : mapped_real_class, ptr, R_NilValue);
+    UNPROTECT(1);
+    return output;
+#else
+    return R_NilValue;
+#endif
+}
@@ -0,0 +1,31 @@
+#include "Rcpp.h"
+
+#include <string>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+// Flushes a file to stable storage before it is renamed into place, so that a
+// crash cannot leave a truncated file at the final path. This is a no-op on
+// Windows, where the rename is already the best we can do.
+// [[Rcpp::export(rng=false)]]
+SEXP sync_file(std::string path) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("failed to open '" + path + "'");
+    }
+    int status = ::fsync(fd);
+    int err = errno;
+    ::close(fd);
+    if (status != 0) {
+        throw std::runtime_error("failed to sync '" + path + "'; " + std::string(std::strerror(err)));
+    }
+#endif
+    return R_NilValue;
+}
@@ -1,9 +1,12 @@
 #include "Rcpp.h"
 #include "takane/takane.hpp"
+#include "Hdf5ListParser.h"
+#include "PagedHdf5File.h"
 
 #include <filesystem>
 #include <string>
 #include <stdexcept>
+#include <unordered_set>
 
 static takane::Options global_options;
 
@@ -267,3 +270,90 @@ Rcpp::RObject deregister_derived_from(std::string type, std::string parent) {
         return Rcpp::LogicalVector::create(false);
     }
 }
+
+/**
+ * Lists saved with list.format="hdf5.packed" are not part of the uzuki2
+ * specification, so we intercept the validation of simple_lists to handle them
+ * ourselves, deferring to takane for all other formats.
+ */
+
+static void validate_packed_list(const std::filesystem::path& path, takane::Options& options) {
+    size_t num_external = 0;
+    auto other_dir = path / "other_contents";
+    if (std::filesystem::exists(other_dir)) {
+        if (!std::filesystem::is_directory(other_dir)) {
+            throw std::runtime_error("expected 'other_contents' to be a directory");
+        }
+
+        std::unordered_set<std::string> present;
+        for (const auto& entry : std::filesystem::directory_iterator(other_dir)) {
+            present.insert(entry.path().filename().string());
+        }
+        num_external = present.size();
+
+        for (size_t i = 0; i < num_external; ++i) {
+            auto name = std::to_string(i);
+            if (present.find(name) == present.end()) {
+                throw std::runtime_error("expected an external list object at 'other_contents/" + name + "'");
+            }
+            try {
+                takane::validate(other_dir / name, options);
+            } catch (std::exception& e) {
+                throw std::runtime_error("failed to validate external list object at 'other_contents/" + name + "'; " + std::string(e.what()));
+            }
+        }
+    }
+
+    auto handle = open_hdf5_file((path / "list_contents.h5").string());
+    JsonValidationExternals others(num_external);
+    Hdf5ListParser<JsonValidationProvisioner, JsonValidationExternals> parser(std::move(others));
+    parser.parse(handle, "simple_list");
+}
+
+// Packed lists get their own type, so we don't have to override the 'simple_list' functions.
+// We also respect any existing registrations and only remove the functions that we installed ourselves.
+static bool packed_validate_installed = false, packed_height_installed = false, packed_interface_installed = false;
+
+//[[Rcpp::export(rng=false)]]
+Rcpp::RObject register_packed_list(bool set) {
+    const std::string type = "packed_simple_list";
+
+    if (set) {
+        if (!has_existing(type, global_options.custom_validate, "old")) {
+            global_options.custom_validate[type] = [](const std::filesystem::path& path, const takane::ObjectMetadata&, takane::Options& options) {
+                validate_packed_list(path, options);
+            };
+            packed_validate_installed = true;
+        }
+
+        if (!has_existing(type, global_options.custom_height, "old")) {
+            global_options.custom_height[type] = [](const std::filesystem::path& path, const takane::ObjectMetadata&, takane::Options&) -> size_t {
+                auto handle = open_hdf5_file((path / "list_contents.h5").string());
+                return Hdf5ListParser<JsonValidationProvisioner, JsonValidationExternals>::length(handle, "simple_list");
+            };
+            packed_height_installed = true;
+        }
+
+        // Packed lists can be used anywhere that a simple list is expected.
+        auto& known = global_options.custom_satisfies_interface["SIMPLE_LIST"];
+        if (known.find(type) == known.end()) {
+            known.insert(type);
+            packed_interface_installed = true;
+        }
+
+    } else {
+        if (packed_validate_installed) {
+            global_options.custom_validate.erase(type);
+            packed_validate_installed = false;
+        }
+        if (packed_height_installed) {
+            global_options.custom_height.erase(type);
+            packed_height_installed = false;
+        }
+        if (packed_interface_installed) {
+            global_options.custom_satisfies_interface["SIMPLE_LIST"].erase(type);
+            packed_interface_installed = false;
+        }
+    }
+    return R_NilValue;
+}